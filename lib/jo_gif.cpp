@@ -4,6 +4,10 @@
  * 	Supports only 4 component input, alpha is currently ignored. (RGBX)
  *
  * Latest revisions:
+ * 	1.04 fixed global palette, frames of palette indices are only compressed
+ * 	1.03 nearest palette entry from an RGB cube of candidate lists instead of an exhaustive search
+ * 	1.02 frames can be encoded in memory, concurrently, and written in order later
+ * 	1.01 reuses the scratch buffers of the state across frames, no whole frame copy
  * 	1.00 (2015-11-03) initial release
  *
  * Basic usage:
@@ -13,6 +17,12 @@
  *	jo_gif_frame(&gif, frame, 4, false); // frame 2
  *	jo_gif_frame(&gif, frame, 4, false); // frame 3, ...
  *	jo_gif_end(&gif);
+ *
+ * Encoding frames concurrently:
+ *	jo_gif_frame_t encoded = jo_gif_frame_alloc(128, 128); // one per thread
+ *	jo_gif_encode(&gif, &encoded, frame, 4, true); // on any thread
+ *	jo_gif_write(&gif, &encoded); // in frame order
+ *	jo_gif_frame_free(&encoded);
  * */
 
 #ifndef JO_INCLUDE_GIF_H
@@ -24,12 +34,29 @@
 // or create jo_gif.h, #define JO_GIF_HEADER_FILE_ONLY, and
 // then include jo_gif.cpp from it.
 
+typedef struct {
+	unsigned char palette[0x300];
+	short delayCsec;
+	bool localPalette;
+	// scratch reused by every frame: 3 rows for dithering, the indexed pixels
+	unsigned char *ditherRows;
+	unsigned char *indexedPixels;
+	// RGB cube of 32^3 cells, each the offset of its candidate list (count, entries) or -1 until a pixel needs it
+	int *cells;
+	unsigned char *candidates;
+	int candidatesSize, candidatesCapacity;
+	// LZW data, already split into sub-blocks
+	unsigned char *data;
+	int dataSize, dataCapacity;
+} jo_gif_frame_t;
+
 typedef struct {
 	FILE *fp;
 	unsigned char palette[0x300];
 	short width, height, repeat;
 	int numColors, palSize;
 	int frame;
+	jo_gif_frame_t scratch; // used by jo_gif_frame
 } jo_gif_t;
 
 // width/height	| the same for every frame
@@ -41,11 +68,36 @@ extern jo_gif_t jo_gif_start(const char *filename, short width, short height, sh
 // rgba         | the pixels
 // delayCsec    | amount of time in between frames (in centiseconds)
 // localPalette | true if you want a unique palette generated for this frame (does not effect future frames)
-extern void jo_gif_frame(jo_gif_t *gif, unsigned char *rgba, short delayCsec, bool localPalette);
+extern void jo_gif_frame(jo_gif_t *gif, const unsigned char *rgba, short delayCsec, bool localPalette);
 
 // gif          | the state (returned from jo_gif_start)
 extern void jo_gif_end(jo_gif_t *gif);
 
+// Buffers to encode frames of width x height into, free with jo_gif_frame_free
+extern jo_gif_frame_t jo_gif_frame_alloc(short width, short height);
+extern void jo_gif_frame_free(jo_gif_frame_t *frame);
+
+// Encodes a frame into memory without touching the file or the state, so
+// several frames may be encoded at once, each into its own jo_gif_frame_t.
+// gif			| the state (returned from jo_gif_start)
+// frame        | receives the encoded frame
+// localPalette | true to learn a palette for this frame. The first frame written
+//              | must have one, it becomes the global palette the other frames
+//              | use, so those may only be encoded once it is written
+extern void jo_gif_encode(const jo_gif_t *gif, jo_gif_frame_t *frame, const unsigned char *rgba, short delayCsec, bool localPalette);
+
+// Appends an encoded frame to the file, frames are shown in the order they are written
+extern void jo_gif_write(jo_gif_t *gif, const jo_gif_frame_t *frame);
+
+// Sets the global palette instead of learning it from the first frame, call before writing frames
+// rgba         | numColors colors, 4 components each (RGBX)
+extern void jo_gif_set_palette(jo_gif_t *gif, const unsigned char *rgba, int numColors);
+
+// Encodes a frame of global palette indices, there is nothing to quantize or dither.
+// Like jo_gif_encode it only reads the state, the first frame written must come with a
+// local palette unless jo_gif_set_palette was called.
+extern void jo_gif_encode_indexed(const jo_gif_t *gif, jo_gif_frame_t *frame, const unsigned char *indices, short delayCsec);
+
 #endif
 
 #ifndef JO_GIF_HEADER_FILE_ONLY
@@ -59,7 +111,7 @@ extern void jo_gif_end(jo_gif_t *gif);
 #include <math.h>
 
 // Based on NeuQuant algorithm
-static void jo_gif_quantize(unsigned char *rgba, int rgbaSize, int sample, unsigned char *map, int numColors) {
+static void jo_gif_quantize(const unsigned char *rgba, int rgbaSize, int sample, unsigned char *map, int numColors) {
 	// defs for freq and bias
 	const int intbiasshift = 16; /* bias for fractions */
 	const int intbias = (((int) 1) << intbiasshift);
@@ -199,7 +251,7 @@ static void jo_gif_quantize(unsigned char *rgba, int rgbaSize, int sample, unsig
 }
 
 typedef struct {
-	FILE *fp;
+	jo_gif_frame_t *out;
 	int numBits;
 	unsigned char buf[256];
 	unsigned char idx;
@@ -208,6 +260,19 @@ typedef struct {
 	int curBits;
 } jo_gif_lzw_t;
 
+// Appends the buffered bytes as a sub-block to the encoded frame
+static void jo_gif_lzw_flush(jo_gif_lzw_t *s) {
+	jo_gif_frame_t *out = s->out;
+	if(out->dataSize + 1 + s->idx > out->dataCapacity) {
+		out->dataCapacity = out->dataCapacity*2 + 1 + s->idx;
+		out->data = (unsigned char *)realloc(out->data, out->dataCapacity);
+	}
+	out->data[out->dataSize++] = s->idx;
+	memcpy(out->data + out->dataSize, s->buf, s->idx);
+	out->dataSize += s->idx;
+	s->idx = 0;
+}
+
 static void jo_gif_lzw_write(jo_gif_lzw_t *s, int code) {
 	s->outBits |= code << s->curBits;
 	s->curBits += s->numBits;
@@ -216,15 +281,13 @@ static void jo_gif_lzw_write(jo_gif_lzw_t *s, int code) {
 		s->outBits >>= 8;
 		s->curBits -= 8;
 		if (s->idx >= 255) {
-			putc(s->idx, s->fp);
-			fwrite(s->buf, s->idx, 1, s->fp);
-			s->idx = 0;
+			jo_gif_lzw_flush(s);
 		}
 	}
 }
 
-static void jo_gif_lzw_encode(unsigned char *in, int len, FILE *fp) {
-	jo_gif_lzw_t state = {fp, 9};
+static void jo_gif_lzw_encode(const unsigned char *in, int len, jo_gif_frame_t *out) {
+	jo_gif_lzw_t state = {out, 9};
 	int maxcode = 511;
 
 	// Note: 30k stack space for dictionary =|
@@ -275,13 +338,50 @@ CONTINUE:
 	jo_gif_lzw_write(&state, 0x101);
 	jo_gif_lzw_write(&state, 0);
 	if(state.idx) {
-		putc(state.idx, fp);
-		fwrite(state.buf, state.idx, 1, fp);
+		jo_gif_lzw_flush(&state);
 	}
 }
 
 static int jo_gif_clamp(int a, int b, int c) { return a < b ? b : a > c ? c : a; }
 
+// The palette entries which can be the nearest one to any color of a cell of
+// 8x8x8 colors: those not farther away than the farthest point of the entry
+// with the closest farthest point. Ties survive, so the lowest index still wins.
+static int jo_gif_cell_candidates(jo_gif_frame_t *frame, const unsigned char *palette, int numColors, int cell) {
+	int lo[3] = { (cell >> 10) << 3, ((cell >> 5) & 31) << 3, (cell & 31) << 3 };
+	int minDist[256];
+	int bestMaxDist = 0x7FFFFFFF;
+	for(int i = 0; i < numColors; ++i) {
+		int minD = 0, maxD = 0;
+		for(int c = 0; c < 3; ++c) {
+			int v = palette[i*3+c];
+			int dLo = v - lo[c], dHi = v - (lo[c] + 7);
+			int near = dLo < 0 ? -dLo : dHi > 0 ? dHi : 0;
+			int far = dLo*dLo > dHi*dHi ? dLo : dHi;
+			minD += near*near;
+			maxD += far*far;
+		}
+		minDist[i] = minD;
+		bestMaxDist = maxD < bestMaxDist ? maxD : bestMaxDist;
+	}
+	if(frame->candidatesSize + 1 + numColors > frame->candidatesCapacity) {
+		frame->candidatesCapacity = frame->candidatesCapacity*2 + 1 + numColors;
+		frame->candidates = (unsigned char *)realloc(frame->candidates, frame->candidatesCapacity);
+	}
+	int offset = frame->candidatesSize;
+	unsigned char *list = frame->candidates + offset;
+	int count = 0;
+	for(int i = 0; i < numColors; ++i) {
+		if(minDist[i] <= bestMaxDist) {
+			list[1 + count++] = i;
+		}
+	}
+	list[0] = count;
+	frame->candidatesSize += 1 + count;
+	frame->cells[cell] = offset;
+	return offset;
+}
+
 jo_gif_t jo_gif_start(const char *filename, short width, short height, short repeat, int numColors) {
 	numColors = numColors > 255 ? 255 : numColors < 2 ? 2 : numColors;
 	jo_gif_t gif = {};
@@ -290,6 +390,7 @@ jo_gif_t jo_gif_start(const char *filename, short width, short height, short rep
 	gif.repeat = repeat;
 	gif.numColors = numColors;
 	gif.palSize = log2(numColors);
+	gif.scratch = jo_gif_frame_alloc(width, height);
 
 	gif.fp = fopen(filename, "wb");
 	if(!gif.fp) {
@@ -306,60 +407,134 @@ jo_gif_t jo_gif_start(const char *filename, short width, short height, short rep
 	return gif;
 }
 
-void jo_gif_frame(jo_gif_t *gif, unsigned char * rgba, short delayCsec, bool localPalette) {
-	if(!gif->fp) {
-		return;
-	}
+jo_gif_frame_t jo_gif_frame_alloc(short width, short height) {
+	jo_gif_frame_t frame = {};
+	frame.ditherRows = (unsigned char *)malloc(width*4*3);
+	frame.indexedPixels = (unsigned char *)malloc(width*height);
+	frame.cells = (int *)malloc(sizeof(int) << 15);
+	return frame;
+}
+
+void jo_gif_frame_free(jo_gif_frame_t *frame) {
+	free(frame->ditherRows);
+	free(frame->indexedPixels);
+	free(frame->cells);
+	free(frame->candidates);
+	free(frame->data);
+	frame->ditherRows = frame->indexedPixels = frame->candidates = frame->data = 0;
+	frame->cells = 0;
+	frame->candidatesSize = frame->candidatesCapacity = 0;
+	frame->dataSize = frame->dataCapacity = 0;
+}
+
+void jo_gif_encode(const jo_gif_t *gif, jo_gif_frame_t *frame, const unsigned char * rgba, short delayCsec, bool localPalette) {
 	short width = gif->width;
 	short height = gif->height;
 	int size = width * height;
 
-	unsigned char localPalTbl[0x300];
-	unsigned char *palette = gif->frame == 0 || !localPalette ? gif->palette : localPalTbl;
-	if(gif->frame == 0 || localPalette) {
-		jo_gif_quantize(rgba, size*4, 1, palette, gif->numColors);		
+	frame->delayCsec = delayCsec;
+	frame->localPalette = localPalette;
+	const unsigned char *palette = gif->palette;
+	if(localPalette) {
+		// the table written is larger than numColors, its tail stays black
+		memset(frame->palette, 0, sizeof(frame->palette));
+		jo_gif_quantize(rgba, size*4, 1, frame->palette, gif->numColors);
+		palette = frame->palette;
 	}
 
-	unsigned char *indexedPixels = (unsigned char *)malloc(size);
+	unsigned char *indexedPixels = frame->indexedPixels;
+	memset(frame->cells, 0xFF, sizeof(int) << 15);
+	frame->candidatesSize = 0;
 	{
-		unsigned char *ditheredPixels = (unsigned char*)malloc(size*4);
-		memcpy(ditheredPixels, rgba, size*4);
-		for(int k = 0; k < size*4; k+=4) {
-			int rgb[3] = { ditheredPixels[k+0], ditheredPixels[k+1], ditheredPixels[k+2] };
-			int bestd = 0x7FFFFFFF, best = -1;
-			// TODO: exhaustive search. do something better.
-			for(int i = 0; i < gif->numColors; ++i) {
-				int bb = palette[i*3+0]-rgb[0];
-				int gg = palette[i*3+1]-rgb[1];
-				int rr = palette[i*3+2]-rgb[2];
-				int d = bb*bb + gg*gg + rr*rr;
-				if(d < bestd) {
-					bestd = d;
-					best = i;
-				}
-			}
-			indexedPixels[k/4] = best;
-			int diff[3] = { ditheredPixels[k+0] - palette[indexedPixels[k/4]*3+0], ditheredPixels[k+1] - palette[indexedPixels[k/4]*3+1], ditheredPixels[k+2] - palette[indexedPixels[k/4]*3+2] };
-			// Floyd-Steinberg Error Diffusion
-			// TODO: Use something better -- http://caca.zoy.org/study/part3.html
-			if(k+4 < size*4) { 
-				ditheredPixels[k+4+0] = (unsigned char)jo_gif_clamp(ditheredPixels[k+4+0]+(diff[0]*7/16), 0, 255); 
-				ditheredPixels[k+4+1] = (unsigned char)jo_gif_clamp(ditheredPixels[k+4+1]+(diff[1]*7/16), 0, 255); 
-				ditheredPixels[k+4+2] = (unsigned char)jo_gif_clamp(ditheredPixels[k+4+2]+(diff[2]*7/16), 0, 255); 
+		// The error diffusion reaches at most two rows ahead (the right neighbour
+		// of the last pixel in a row is the first one of the next row), so only
+		// three rows are staged instead of a copy of the whole frame.
+		int rowSize = width*4;
+		unsigned char *rows[3] = { frame->ditherRows, frame->ditherRows + rowSize, frame->ditherRows + rowSize*2 };
+		memcpy(rows[0], rgba, rowSize);
+		if(height > 1) {
+			memcpy(rows[1], rgba + rowSize, rowSize);
+		}
+		for(int y = 0; y < height; ++y) {
+			unsigned char *cur = rows[y % 3], *next = rows[(y+1) % 3], *next2 = rows[(y+2) % 3];
+			if(y+2 < height) {
+				memcpy(next2, rgba + (y+2)*rowSize, rowSize);
 			}
-			if(k+width*4+4 < size*4) { 
-				for(int i = 0; i < 3; ++i) {
-					ditheredPixels[k-4+width*4+i] = (unsigned char)jo_gif_clamp(ditheredPixels[k-4+width*4+i]+(diff[i]*3/16), 0, 255); 
-					ditheredPixels[k+width*4+i] = (unsigned char)jo_gif_clamp(ditheredPixels[k+width*4+i]+(diff[i]*5/16), 0, 255); 
-					ditheredPixels[k+width*4+4+i] = (unsigned char)jo_gif_clamp(ditheredPixels[k+width*4+4+i]+(diff[i]*1/16), 0, 255); 
+			for(int x = 0; x < width; ++x) {
+				int k = (y*width + x)*4;
+				unsigned char *px = cur + x*4;
+				int rgb[3] = { px[0], px[1], px[2] };
+				int bestd = 0x7FFFFFFF, best = -1;
+				int cell = ((rgb[0] >> 3) << 10) | ((rgb[1] >> 3) << 5) | (rgb[2] >> 3);
+				int offset = frame->cells[cell];
+				if(offset < 0) {
+					offset = jo_gif_cell_candidates(frame, palette, gif->numColors, cell);
+				}
+				const unsigned char *candidates = frame->candidates + offset;
+				for(int n = 1; n <= candidates[0]; ++n) {
+					int i = candidates[n];
+					int bb = palette[i*3+0]-rgb[0];
+					int gg = palette[i*3+1]-rgb[1];
+					int rr = palette[i*3+2]-rgb[2];
+					int d = bb*bb + gg*gg + rr*rr;
+					if(d < bestd) {
+						bestd = d;
+						best = i;
+					}
+				}
+				indexedPixels[k/4] = best;
+				int diff[3] = { px[0] - palette[best*3+0], px[1] - palette[best*3+1], px[2] - palette[best*3+2] };
+				// Floyd-Steinberg Error Diffusion
+				// TODO: Use something better -- http://caca.zoy.org/study/part3.html
+				if(k+4 < size*4) { 
+					unsigned char *right = x+1 < width ? px+4 : next;
+					right[0] = (unsigned char)jo_gif_clamp(right[0]+(diff[0]*7/16), 0, 255); 
+					right[1] = (unsigned char)jo_gif_clamp(right[1]+(diff[1]*7/16), 0, 255); 
+					right[2] = (unsigned char)jo_gif_clamp(right[2]+(diff[2]*7/16), 0, 255); 
+				}
+				if(k+width*4+4 < size*4) { 
+					unsigned char *belowLeft = x > 0 ? next + (x-1)*4 : cur + (width-1)*4;
+					unsigned char *below = next + x*4;
+					unsigned char *belowRight = x+1 < width ? next + (x+1)*4 : next2;
+					for(int i = 0; i < 3; ++i) {
+						belowLeft[i] = (unsigned char)jo_gif_clamp(belowLeft[i]+(diff[i]*3/16), 0, 255); 
+						below[i] = (unsigned char)jo_gif_clamp(below[i]+(diff[i]*5/16), 0, 255); 
+						belowRight[i] = (unsigned char)jo_gif_clamp(belowRight[i]+(diff[i]*1/16), 0, 255); 
+					}
 				}
 			}
 		}
-		free(ditheredPixels);
+	}
+	frame->dataSize = 0;
+	jo_gif_lzw_encode(indexedPixels, size, frame);
+}
+
+void jo_gif_set_palette(jo_gif_t *gif, const unsigned char *rgba, int numColors) {
+	memset(gif->palette, 0, sizeof(gif->palette));
+	for(int i = 0; i < numColors && i < 256; ++i) {
+		gif->palette[i*3+0] = rgba[i*4+0];
+		gif->palette[i*3+1] = rgba[i*4+1];
+		gif->palette[i*3+2] = rgba[i*4+2];
+	}
+}
+
+void jo_gif_encode_indexed(const jo_gif_t *gif, jo_gif_frame_t *frame, const unsigned char *indices, short delayCsec) {
+	frame->delayCsec = delayCsec;
+	frame->localPalette = false;
+	frame->dataSize = 0;
+	jo_gif_lzw_encode(indices, gif->width * gif->height, frame);
+}
+
+void jo_gif_write(jo_gif_t *gif, const jo_gif_frame_t *frame) {
+	if(!gif->fp) {
+		return;
 	}
 	if(gif->frame == 0) {
-		// Global Color Table
-		fwrite(palette, 3*(1<<(gif->palSize+1)), 1, gif->fp);
+		// Global Color Table, learned from the first frame unless it was set
+		if(frame->localPalette) {
+			memcpy(gif->palette, frame->palette, sizeof(gif->palette));
+		}
+		fwrite(gif->palette, 3*(1<<(gif->palSize+1)), 1, gif->fp);
 		if(gif->repeat >= 0) {
 			// Netscape Extension
 			fwrite("\x21\xff\x0bNETSCAPE2.0\x03\x01", 16, 1, gif->fp);
@@ -369,26 +544,34 @@ void jo_gif_frame(jo_gif_t *gif, unsigned char * rgba, short delayCsec, bool loc
 	}
 	// Graphic Control Extension
 	fwrite("\x21\xf9\x04\x00", 4, 1, gif->fp);
-	fwrite(&delayCsec, 2, 1, gif->fp); // delayCsec x 1/100 sec
+	fwrite(&frame->delayCsec, 2, 1, gif->fp); // delayCsec x 1/100 sec
 	fwrite("\x00\x00", 2, 1, gif->fp); // transparent color index (first byte), currently unused
 	// Image Descriptor
 	fwrite("\x2c\x00\x00\x00\x00", 5, 1, gif->fp); // header, x,y
-	fwrite(&width, 2, 1, gif->fp);
-	fwrite(&height, 2, 1, gif->fp);
-	if (gif->frame == 0 || !localPalette) {
+	fwrite(&gif->width, 2, 1, gif->fp);
+	fwrite(&gif->height, 2, 1, gif->fp);
+	if (gif->frame == 0 || !frame->localPalette) {
 		putc(0, gif->fp);
 	} else {
 		putc(0x80|gif->palSize, gif->fp );
-		fwrite(palette, 3*(1<<(gif->palSize+1)), 1, gif->fp);
+		fwrite(frame->palette, 3*(1<<(gif->palSize+1)), 1, gif->fp);
 	}
 	putc(8, gif->fp); // block terminator
-	jo_gif_lzw_encode(indexedPixels, size, gif->fp);
+	fwrite(frame->data, frame->dataSize, 1, gif->fp);
 	putc(0, gif->fp); // block terminator
 	++gif->frame;
-	free(indexedPixels);
+}
+
+void jo_gif_frame(jo_gif_t *gif, const unsigned char * rgba, short delayCsec, bool localPalette) {
+	if(!gif->fp) {
+		return;
+	}
+	jo_gif_encode(gif, &gif->scratch, rgba, delayCsec, gif->frame == 0 || localPalette);
+	jo_gif_write(gif, &gif->scratch);
 }
 
 void jo_gif_end(jo_gif_t *gif) {
+	jo_gif_frame_free(&gif->scratch);
 	if(!gif->fp) {
 		return;
 	}
@@ -3,6 +3,9 @@
 #include <string>
 #include <vector>
 #include <chrono>
+#include <stdexcept>
+#include <mutex>
+#include <condition_variable>
 
 #include "jo_gif.h"
 #include "types.h"
@@ -11,23 +14,104 @@ class AnimatedGif {
 	std::string _file_name;
 	size_t _frame_size;
 	jo_gif_t _gif;
+	/** Frames written to the file so far, write_frame waits for its turn */
+	size_t _written = 0;
+	std::mutex _mutex;
+	std::condition_variable _written_changed;
 
 public:
+	/** Frame encoded in memory, keep one per encoding thread as its buffers are reused by every frame */
+	class EncodedFrame {
+		jo_gif_frame_t _frame;
+		friend class AnimatedGif;
+
+	public:
+		EncodedFrame(short width, short height)
+			: _frame{jo_gif_frame_alloc(width, height)} { }
+
+		EncodedFrame(const EncodedFrame&) = delete;
+		EncodedFrame& operator=(const EncodedFrame&) = delete;
+
+		~EncodedFrame() {
+			jo_gif_frame_free(&_frame);
+		}
+	};
+
 	AnimatedGif(const std::string& file_name, short width, short height)
 		: _file_name{file_name} {
 		_gif = jo_gif_start(_file_name.c_str(), width, height, 1, 32);
 		_frame_size = width * height;
 	}
 
-    void append_frame(std::vector<pixel_t> frame, std::chrono::duration<short, std::centi> delay, bool localPalette = false) {
-		if (frame.size() != _frame_size) {
-			throw "H"; // TODO Proper exception
+	/** Every frame uses the given palette (at most 256 colors), frames are appended as palette indices */
+	AnimatedGif(const std::string& file_name, short width, short height, const std::vector<pixel_t>& palette)
+		: _file_name{file_name} {
+		_gif = jo_gif_start(_file_name.c_str(), width, height, 1, (int)palette.size());
+		jo_gif_set_palette(&_gif, reinterpret_cast<const unsigned char *>(palette.data()), (int)palette.size());
+		_frame_size = width * height;
+	}
+
+	// _gif owns the file and the scratch buffers of the encoder
+	AnimatedGif(const AnimatedGif&) = delete;
+	AnimatedGif& operator=(const AnimatedGif&) = delete;
+
+	/** Encodes the pixels in place, the scratch buffers of the encoder are reused by every frame */
+	void append_frame(const pixel_t* pixels, size_t pixel_count, std::chrono::duration<short, std::centi> delay, bool localPalette = false) {
+		check_size(pixel_count);
+
+		std::lock_guard<std::mutex> lock(_mutex);
+		jo_gif_frame(&_gif, reinterpret_cast<const unsigned char *>(pixels), delay.count(), localPalette);
+		_written++;
+		_written_changed.notify_all();
+	}
+
+	void append_frame(const std::vector<pixel_t>& frame, std::chrono::duration<short, std::centi> delay, bool localPalette = false) {
+		append_frame(frame.data(), frame.size(), delay, localPalette);
+	}
+
+	EncodedFrame encoded_frame() const {
+		return EncodedFrame(_gif.width, _gif.height);
+	}
+
+	/**
+	Encodes the index-th frame of the file without writing it, so several threads
+	may encode frames at once. Frames without a local palette use the one of the
+	first frame and wait until it is written.
+	*/
+	void encode_frame(EncodedFrame& encoded, size_t index, const pixel_t* pixels, size_t pixel_count, std::chrono::duration<short, std::centi> delay, bool localPalette = false) {
+		check_size(pixel_count);
+
+		if (index > 0 && !localPalette) {
+			std::unique_lock<std::mutex> lock(_mutex);
+			_written_changed.wait(lock, [this] { return _written > 0; });
 		}
+		jo_gif_encode(&_gif, &encoded._frame, reinterpret_cast<const unsigned char *>(pixels), delay.count(), index == 0 || localPalette);
+	}
 
-		jo_gif_frame(&_gif, reinterpret_cast<unsigned char *>(frame.data()), delay.count(), localPalette);
+	/** Frame of indices into the palette given to the constructor, only compressed */
+	void encode_frame(EncodedFrame& encoded, const palette_index_t* indices, size_t pixel_count, std::chrono::duration<short, std::centi> delay) {
+		check_size(pixel_count);
+
+		jo_gif_encode_indexed(&_gif, &encoded._frame, indices, delay.count());
+	}
+
+	/** Writes the index-th frame, blocks until the frames before it are written */
+	void write_frame(size_t index, const EncodedFrame& encoded) {
+		std::unique_lock<std::mutex> lock(_mutex);
+		_written_changed.wait(lock, [this, index] { return _written == index; });
+		jo_gif_write(&_gif, &encoded._frame);
+		_written++;
+		_written_changed.notify_all();
 	}
 
 	~AnimatedGif() {
 		jo_gif_end(&_gif);
 	}
-};
\ No newline at end of file
+
+private:
+	void check_size(size_t pixel_count) const {
+		if (pixel_count != _frame_size) {
+			throw std::invalid_argument("frame has " + std::to_string(pixel_count) + " pixels, expected " + std::to_string(_frame_size));
+		}
+	}
+};
@@ -0,0 +1,130 @@
+#pragma once
+
+#include <cmath>
+#include <string>
+#include <string_view>
+#include <stdexcept>
+
+/**
+Unevaluated sum hi + lo of two doubles with |lo| <= ulp (hi) / 2, ~106 bits of
+mantissa. Sums and products are exact in two doubles (see two_sum and
+two_prod), so only the rounding of lo is lost per operation.
+*/
+struct dd_real
+{
+	double hi;
+	double lo;
+
+	dd_real (double value = 0)
+		: hi{ value }, lo{ 0 } { }
+
+	dd_real (double hi, double lo)
+		: hi{ hi }, lo{ lo } { }
+
+	/** a + b = sum + error exactly, for any a and b */
+	static dd_real two_sum (double a, double b) {
+		double sum = a + b;
+		double b_virtual = sum - a;
+		double error = (a - (sum - b_virtual)) + (b - b_virtual);
+		return { sum, error };
+	}
+
+	/** two_sum for |a| >= |b| */
+	static dd_real quick_two_sum (double a, double b) {
+		double sum = a + b;
+		return { sum, b - (sum - a) };
+	}
+
+	/** a * b = product + error exactly, the fma rounds only once */
+	static dd_real two_prod (double a, double b) {
+		double product = a * b;
+		return { product, std::fma (a, b, -product) };
+	}
+
+	explicit operator double () const {
+		return hi + lo;
+	}
+
+	friend dd_real operator+ (const dd_real& a, const dd_real& b) {
+		dd_real sum = two_sum (a.hi, b.hi);
+		dd_real error = two_sum (a.lo, b.lo);
+		sum = quick_two_sum (sum.hi, sum.lo + error.hi);
+		return quick_two_sum (sum.hi, sum.lo + error.lo);
+	}
+
+	friend dd_real operator- (const dd_real& a) {
+		return { -a.hi, -a.lo };
+	}
+
+	friend dd_real operator- (const dd_real& a, const dd_real& b) {
+		return a + -b;
+	}
+
+	friend dd_real operator* (const dd_real& a, const dd_real& b) {
+		dd_real product = two_prod (a.hi, b.hi);
+		return quick_two_sum (product.hi, product.lo + (a.hi * b.lo + a.lo * b.hi));
+	}
+
+	/** Long division, a quotient digit of double per step */
+	friend dd_real operator/ (const dd_real& a, const dd_real& b) {
+		double q1 = a.hi / b.hi;
+		dd_real r = a - b * q1;
+		double q2 = r.hi / b.hi;
+		r = r - b * q2;
+		double q3 = r.hi / b.hi;
+		return quick_two_sum (q1, q2) + q3;
+	}
+
+	/**
+	Decimal number like "-0.74364388703715870475219150611477" or "1.5e-20",
+	to the ~32 digits double-double resolves. Points deeper than double can
+	only be given this way, a double literal is rounded before it gets here.
+	*/
+	static dd_real parse (std::string_view text) {
+		size_t i = 0;
+		bool negative = false;
+		if (!text.empty () && (text[0] == '-' || text[0] == '+')) {
+			negative = text[0] == '-';
+			i++;
+		}
+		dd_real mantissa;
+		int exponent = 0;
+		size_t digits = 0;
+		bool point = false;
+		for (; i < text.size (); i++)
+		{
+			char c = text[i];
+			if (c == '.' && !point) {
+				point = true;
+			}
+			else if (c >= '0' && c <= '9') {
+				mantissa = mantissa * 10.0 + (double)(c - '0');
+				exponent -= point;
+				digits++;
+			}
+			else {
+				break;
+			}
+		}
+		if (i < text.size () && (text[i] == 'e' || text[i] == 'E')) {
+			try {
+				size_t used = 0;
+				exponent += std::stoi (std::string (text.substr (i + 1)), &used);
+				i += 1 + used;
+			}
+			catch (const std::exception&) {
+				i = 0;
+			}
+		}
+		if (digits == 0 || i != text.size ())
+			throw std::invalid_argument ("not a decimal number: " + std::string (text));
+
+		dd_real scale = 1;
+		for (int e = 0; e < std::abs (exponent); e++)
+		{
+			scale = scale * 10.0;
+		}
+		dd_real value = exponent < 0 ? mantissa / scale : mantissa * scale;
+		return negative ? -value : value;
+	}
+};
@@ -1,11 +1,76 @@
 #pragma once
 
 #include <complex>
+#include <array>
+#include <tuple>
+#include <vector>
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <string_view>
 
 #include "frac_constants.h"
 #include "types.h"
+#include "double_double.h"
 
 using complex_t = std::complex<float>;
+/** Bounds of the frames, the pixel spacing of a deep zoom is below float resolution */
+using complex_d_t = std::complex<double>;
+
+/** Point in double-double, which a deep zoom aims at below the resolution of double */
+struct complex_dd_t
+{
+	dd_real real;
+	dd_real imag;
+
+	complex_dd_t (dd_real real = 0, dd_real imag = 0)
+		: real{ real }, imag{ imag } { }
+
+	complex_dd_t (const complex_t& c)
+		: real{ c.real () }, imag{ c.imag () } { }
+
+	/** Both parts of decimal numbers, see dd_real::parse */
+	static complex_dd_t parse (std::string_view real, std::string_view imag) {
+		return { dd_real::parse (real), dd_real::parse (imag) };
+	}
+
+	/** Nearest point in double */
+	complex_d_t to_double () const {
+		return { (double)real, (double)imag };
+	}
+};
+
+/**
+Orbit Z_0 = 0, Z_n+1 = Z_n^2 + C of a reference point C up to its escape or
+the largest budget, the real and imaginary parts apart so that the kernels
+gather them directly.
+*/
+struct reference_orbit_t
+{
+	std::vector<double> real;
+	std::vector<double> imag;
+
+	size_t size () const {
+		return real.size ();
+	}
+};
+
+/**
+Offsets of the pixels of a frame from the reference orbit after skipped
+iterations, a polynomial of their offset dc from the reference point:
+  delta_skipped = a u + b u^2 + c u^3  with u = dc / radius
+The coefficients are scaled by powers of radius, so they stay in the range of
+double at any depth. skipped is 0 when the frame is not approximated.
+*/
+struct series_t
+{
+	size_t skipped = 0;
+	/** Largest |dc| of the frame */
+	double radius = 1;
+	complex_d_t a;
+	complex_d_t b;
+	complex_d_t c;
+};
 
 struct FractalZooming
 {
@@ -15,13 +80,252 @@ struct FractalZooming
 		No
 	};
 
+	/** Closed-form test which marks points as bounded before iterating them */
+	enum class InteriorCheck
+	{
+		No,
+		CardioidAndBulb
+	};
+
+	/** Stops iterating points whose orbit entered a cycle */
+	enum class PeriodicityCheck
+	{
+		No,
+		Brent
+	};
+
+	/** What the renderers store per pixel */
+	enum class FrameFormat
+	{
+		RGBA,
+		/** Index into palette (), the gif uses it as its global palette and skips quantizing */
+		PaletteIndices,
+		/** Index into colors (), half the size of RGBA and colored again without rendering */
+		IterationCounts
+	};
+
+	/** How a pixel gets its color */
+	enum class Coloring
+	{
+		/** Entry of color_map per iteration count */
+		Iterations,
+		/** Normalized iteration count through gradient, without bands between the counts */
+		Smooth
+	};
+
+	/** How the kernels iterate a frame */
+	enum class Precision
+	{
+		/** The fastest of the others which resolves the pixel spacing, see frame_precision */
+		Auto,
+		Float,
+		Double,
+		/**
+		Pixels as double offsets from the reference_orbit of zoom_center, which
+		keep their precision at any depth. Needs compute_reference_orbit.
+		*/
+		Perturbation,
+		/**
+		Pixels in double-double (see dd_real), ~106 bits of mantissa, which
+		resolve frames down to a pixel spacing of ~1e-30 without a reference
+		orbit at several times the cost of double.
+		*/
+		DoubleDouble
+	};
+
+	/** How many iterations perturbation frames skip */
+	enum class SeriesApproximation
+	{
+		No,
+		/** As many as a series of 3 terms approximates, see frame_series */
+		Cubic
+	};
+
 	complex_t start_lower_left;
 	complex_t start_upper_right;
 	float zoom;
 	size_t zoom_steps;
-	complex_t zoom_center;
+	/** Point the frames close in on, see complex_dd_t::parse for one deeper than float */
+	complex_dd_t zoom_center;
 	SaveImage save_images;
-	pixel_t color_map[COLOR_COUNT];
+	InteriorCheck interior_check;
+	PeriodicityCheck periodicity_check;
+	/** Iteration budget of the first frame */
+	size_t iterations;
+	/** Number of frames after which the budget doubles, 0 keeps it constant */
+	size_t iterations_doubling;
+	/** Color per iteration count, its size is the largest budget of a frame */
+	std::vector<pixel_t> color_map;
+	FrameFormat frame_format = FrameFormat::RGBA;
+	Coloring coloring = Coloring::Iterations;
+	/** Colors of the smooth coloring, escaped points cycle through all but the last one, which bounded points get */
+	std::vector<pixel_t> gradient;
+	/** Iterations per cycle through the gradient */
+	float gradient_period = 32;
+	Precision precision = Precision::Auto;
+	/** Orbit of zoom_center, see compute_reference_orbit */
+	reference_orbit_t reference_orbit;
+	/** Frames iterated by perturbation skip the first iterations, see frame_series */
+	SeriesApproximation series_approximation = SeriesApproximation::Cubic;
+
+	/** Iteration budget of the given frame, grows with the zoom depth */
+	size_t frame_iterations (size_t frame) const {
+		size_t budget = iterations_doubling == 0
+			? iterations
+			: iterations << std::min<size_t> (frame / iterations_doubling, 32);
+		return std::min (budget, color_map.size ());
+	}
+
+	/**
+	Lower left and upper right corner of the given frame relative to
+	zoom_center. Every frame after the first is centered on zoom_center and
+	zoom times the size of the one before, so the corners are exact at any depth
+	and no frame depends on the ones before it.
+	*/
+	std::tuple<complex_d_t, complex_d_t> frame_bounds (size_t frame) const {
+		if (frame == 0)
+			return std::make_tuple (relative_to_center (start_lower_left), relative_to_center (start_upper_right));
+		complex_d_t size = complex_d_t (start_upper_right) - complex_d_t (start_lower_left);
+		complex_d_t half_size = size * (std::pow ((double)zoom, (double)frame) / 2);
+		return std::make_tuple (-half_size, half_size);
+	}
+
+	/** point - zoom_center, subtracted in double-double and rounded afterwards */
+	complex_d_t relative_to_center (const complex_t& point) const {
+		return {
+			(double)(dd_real (point.real ()) - zoom_center.real),
+			(double)(dd_real (point.imag ()) - zoom_center.imag)
+		};
+	}
+
+	/**
+	Precision a frame with this pixel spacing is iterated with. Float has 24
+	bits of mantissa and double 53, once the pixel spacing spans only a few
+	steps of them (see FRACTAL_FLOAT_PIXEL_BITS) neighboring pixels round to the
+	same points and the frame turns blocky. Deeper frames take perturbation,
+	which is faster than double-double, and double-double without a reference
+	orbit.
+	*/
+	Precision frame_precision (const std::array<double, 2>& scale) const {
+		bool has_reference = reference_orbit.size () != 0;
+		if (precision == Precision::Perturbation && !has_reference)
+			throw std::invalid_argument ("perturbation needs the reference orbit, see compute_reference_orbit");
+		if (precision != Precision::Auto)
+			return precision;
+		double magnitude = std::max ({ 1.0, std::abs ((double)zoom_center.real), std::abs ((double)zoom_center.imag) });
+		double spacing = std::min (scale[0], scale[1]);
+		if (spacing >= std::ldexp (magnitude, FRACTAL_FLOAT_PIXEL_BITS - 24))
+			return Precision::Float;
+		if (spacing >= std::ldexp (magnitude, FRACTAL_FLOAT_PIXEL_BITS - 53))
+			return Precision::Double;
+		return has_reference ? Precision::Perturbation : Precision::DoubleDouble;
+	}
+
+	/**
+	Iterates zoom_center in double-double for the largest budget. The pixels of
+	a deep frame only differ from it in digits double no longer has, rounding
+	the orbit to double afterwards keeps those digits in the offsets.
+	*/
+	void compute_reference_orbit () {
+		size_t length = std::max (iterations, color_map.size ()) + 1;
+		reference_orbit.real.clear ();
+		reference_orbit.imag.clear ();
+		dd_real c_real = zoom_center.real;
+		dd_real c_imag = zoom_center.imag;
+		dd_real z_real, z_imag;
+		for (size_t i = 0; i < length; i++)
+		{
+			reference_orbit.real.push_back ((double)z_real);
+			reference_orbit.imag.push_back ((double)z_imag);
+			double mag = reference_orbit.real.back () * reference_orbit.real.back ()
+				+ reference_orbit.imag.back () * reference_orbit.imag.back ();
+			if (mag > FRACTAL_BOUND)
+				break;
+
+			dd_real real_sq = z_real * z_real;
+			dd_real imag_sq = z_imag * z_imag;
+			dd_real prod = z_real * z_imag;
+			z_real = real_sq - imag_sq + c_real;
+			z_imag = prod + prod + c_imag;
+		}
+	}
+
+	/**
+	Series of the offsets of the frame with the given bounds and pixel
+	spacing (see compute_scale), for frames iterated by perturbation. The
+	coefficients follow the reference orbit with
+	  a' = 2 Z a + radius,  b' = 2 Z b + a^2,  c' = 2 Z c + 2 a b
+	and the first term left out, d' = 2 Z d + 2 a c + b^2, bounds their error.
+	It stops before that error reaches FRACTAL_SERIES_TOLERANCE of the
+	distance of two pixels after those iterations, |a| / radius times the
+	spacing, and before the offsets get as large as the reference or pass the
+	bound, where the pixels need rebasing.
+	*/
+	series_t frame_series (const complex_d_t& lower_left, const complex_d_t& upper_right, const std::array<double, 2>& scale, size_t iterations) const {
+		series_t series;
+		if (series_approximation == SeriesApproximation::No || frame_precision (scale) != Precision::Perturbation)
+			return series;
+
+		series.radius = std::hypot (
+			std::max (std::abs (lower_left.real ()), std::abs (upper_right.real ())),
+			std::max (std::abs (lower_left.imag ()), std::abs (upper_right.imag ())));
+		double tolerance = FRACTAL_SERIES_TOLERANCE * std::min (scale[0], scale[1]) / series.radius;
+		// the pixels need an iteration of their own before the budget or the reference ends
+		size_t last = std::min (iterations, reference_orbit.size ()) - 1;
+		complex_d_t a, b, c, d;
+		for (size_t n = 0; n + 1 < last; n++)
+		{
+			complex_d_t z_2{ 2 * reference_orbit.real[n], 2 * reference_orbit.imag[n] };
+			complex_d_t next_d = z_2 * d + 2.0 * a * c + b * b;
+			complex_d_t next_c = z_2 * c + 2.0 * a * b;
+			complex_d_t next_b = z_2 * b + a * a;
+			complex_d_t next_a = z_2 * a + series.radius;
+
+			double z_mag = std::hypot (reference_orbit.real[n + 1], reference_orbit.imag[n + 1]);
+			double delta_mag = std::abs (next_a) + std::abs (next_b) + std::abs (next_c);
+			if (std::abs (next_d) > tolerance * std::abs (next_a)
+				|| delta_mag >= z_mag
+				|| (z_mag + delta_mag) * (z_mag + delta_mag) > FRACTAL_BOUND)
+				break;
+
+			a = next_a;
+			b = next_b;
+			c = next_c;
+			d = next_d;
+			series.skipped = n + 1;
+		}
+		series.a = a;
+		series.b = b;
+		series.c = c;
+		return series;
+	}
+
+	/** The colors the pixels index, the color map or the gradient with smooth coloring */
+	const std::vector<pixel_t>& colors () const {
+		return coloring == Coloring::Smooth ? gradient : color_map;
+	}
+
+	/** Colors of the palette the colors are reduced to, a gif has at most 256 */
+	size_t palette_size () const {
+		return std::min<size_t> (colors ().size (), 256);
+	}
+
+	/** Palette entry of one of the colors, neighboring colors share an entry if there are many */
+	palette_index_t palette_index (size_t color) const {
+		size_t count = colors ().size ();
+		return (palette_index_t)(count <= 256 ? color : color * 256 / count);
+	}
+
+	/** Entry i is the first of the colors with palette_index i */
+	std::vector<pixel_t> palette () const {
+		const auto& all = colors ();
+		std::vector<pixel_t> palette (palette_size ());
+		for (size_t i = 0; i < palette.size (); i++)
+		{
+			palette[i] = all[(i * all.size () + palette.size () - 1) / palette.size ()];
+		}
+		return palette;
+	}
 };
 
 inline constexpr pixel_t interpolate(const pixel_t &start, const pixel_t &end, double t)
@@ -34,48 +338,53 @@ inline constexpr pixel_t interpolate(const pixel_t &start, const pixel_t &end, d
 	};
 }
 
-inline
-std::array<float, 2> compute_scale(const complex_t& lower_left, const complex_t& upper_right, const short width, const short height) {
-	return std::array<float, 2>{
-		(upper_right.real() - lower_left.real()) / width,
-		(upper_right.imag() - lower_left.imag()) / height
+/** Hue in degrees, saturation and value in [0, 1] */
+inline pixel_t hsv_to_rgb (float hue, float saturation, float value)
+{
+	float h = std::fmod (hue, 360.0f) / 60;
+	if (h < 0)
+		h += 6;
+	float chroma = value * saturation;
+	float x = chroma * (1 - std::abs (std::fmod (h, 2.0f) - 1));
+	float m = value - chroma;
+	std::array<float, 3> rgb;
+	switch ((int)h % 6)
+	{
+		case 0: rgb = { chroma, x, 0 }; break;
+		case 1: rgb = { x, chroma, 0 }; break;
+		case 2: rgb = { 0, chroma, x }; break;
+		case 3: rgb = { 0, x, chroma }; break;
+		case 4: rgb = { x, 0, chroma }; break;
+		default: rgb = { chroma, 0, x }; break;
+	}
+	return pixel_t{
+		(unsigned char)std::lround ((rgb[0] + m) * 255),
+		(unsigned char)std::lround ((rgb[1] + m) * 255),
+		(unsigned char)std::lround ((rgb[2] + m) * 255),
+		0
 	};
 }
 
-std::tuple<complex_t, complex_t> zoom_and_re_center(const complex_t &lower_left, const complex_t &upper_right, const FractalZooming &zooming)
+/**
+Gradient for FractalZooming::gradient, entries - 1 colors once around the hue
+circle and the color of bounded points. 256 entries make it a gif palette as well.
+*/
+inline std::vector<pixel_t> hsv_gradient (size_t entries, pixel_t bounded, float saturation = 0.8f, float value = 1.0f)
 {
-	// Zoom and ...
-	auto new_lower_left = lower_left * zooming.zoom;
-	auto new_upper_right = upper_right * zooming.zoom;
-
-	auto current_center = (new_lower_left + new_upper_right);
-	current_center = complex_t(
-		current_center.real() / 2,
-		current_center.imag() / 2
-	);
-
-	// move towards zoom_center
-	auto translate = zooming.zoom_center - current_center;
-	new_lower_left = new_lower_left + translate;
-	new_upper_right = new_upper_right + translate;
-
-	return std::make_tuple(new_lower_left, new_upper_right);
+	std::vector<pixel_t> gradient (entries);
+	for (size_t i = 0; i + 1 < entries; i++)
+	{
+		gradient[i] = hsv_to_rgb (360.0f * i / (entries - 1), saturation, value);
+	}
+	gradient.back () = bounded;
+	return gradient;
 }
 
-void zoom_and_re_center_inplace(complex_t &lower_left, complex_t &upper_right, const FractalZooming &zooming)
-{
-	// Zoom and ...
-	lower_left = lower_left * zooming.zoom;
-	upper_right = upper_right * zooming.zoom;
-
-	auto current_center = (lower_left + upper_right);
-	current_center = complex_t(
-		current_center.real() / 2,
-		current_center.imag() / 2
-	);
-
-	// move towards zoom_center
-	auto translate = zooming.zoom_center - current_center;
-	lower_left = lower_left + translate;
-	upper_right = upper_right + translate;
+/** Distance between two pixels, in float or double as the bounds are */
+template<typename real_type>
+std::array<real_type, 2> compute_scale(const std::complex<real_type>& lower_left, const std::complex<real_type>& upper_right, const short width, const short height) {
+	return std::array<real_type, 2>{
+		(upper_right.real() - lower_left.real()) / width,
+		(upper_right.imag() - lower_left.imag()) / height
+	};
 }
@@ -1,6 +1,11 @@
 #pragma once
 
+// default iteration budget
 #define FRACTAL_ITER 128
 #define FRACTAL_BOUND 32
-
-#define COLOR_COUNT FRACTAL_ITER
\ No newline at end of file
+// max. distance to a previous orbit point to consider the orbit periodic
+#define FRACTAL_PERIOD_EPSILON 1e-6f
+// float steps between two pixels are at least 2^FRACTAL_FLOAT_PIXEL_BITS, deeper frames are iterated in double
+#define FRACTAL_FLOAT_PIXEL_BITS 4
+// error of the series approximation of deep frames, in pixels
+#define FRACTAL_SERIES_TOLERANCE 1e-3
@@ -3,22 +3,140 @@
 #include <vector>
 #include <array>
 #include <tuple>
-#include <map>
+#include <deque>
 #include <thread>
 #include <future>
+#include <mutex>
+#include <atomic>
+#include <exception>
+#include <utility>
+#include <typeinfo>
+#include <string_view>
+#include <sstream>
+#include <iomanip>
+#include <numeric>
+#include <limits>
 
 #include "animated_gif.h"
 #include "frac.h"
+#include "frac_kernel.h"
 #include "timer.h"
 #include "parallelizer.h"
+#include "tile_scheduler.h"
+#include "frame_ring.h"
+#include "frame_sink.h"
+#include "frame_store.h"
 
 #include "instruction_set.h"
-#include "immintrin.h"
 
 using namespace std::string_view_literals;
 using namespace std::literals::chrono_literals;
 
 const InstructionSet::InstructionSet_Internal InstructionSet::CPU_Rep;
+
+/** Best extension the host (CPU and OS) supports */
+inline FracUseCPUExt detect_cpu_ext () {
+	bool avx = InstructionSet::AVX () && InstructionSet::OS_AVX ();
+	bool avx2_fma = avx && InstructionSet::AVX2 () && InstructionSet::FMA ();
+	if (avx2_fma && InstructionSet::AVX512F () && InstructionSet::OS_AVX512 ())
+		return FracUseCPUExt::AVX512;
+	if (avx2_fma)
+		return FracUseCPUExt::AVX_FMA;
+	if (avx)
+		return FracUseCPUExt::AVX;
+	return FracUseCPUExt::None;
+}
+
+/** Row kernel of an extension chosen at runtime, see frac_fill_row */
+inline fill_row_fn select_row_kernel (FracUseCPUExt cpu_ext, int pixels_size) {
+	switch (cpu_ext)
+	{
+		case FracUseCPUExt::AVX:
+			return frac_fill_row<FracUseCPUExt::AVX> (pixels_size);
+		case FracUseCPUExt::AVX_FMA:
+			return frac_fill_row<FracUseCPUExt::AVX_FMA> (pixels_size);
+		case FracUseCPUExt::AVX512:
+			return frac_fill_row<FracUseCPUExt::AVX512> (pixels_size);
+		default:
+			return frac_fill_row<FracUseCPUExt::None> (pixels_size);
+	}
+}
+
+/** Row kernel writing palette indices, see frac_fill_index_row */
+inline fill_index_row_fn select_index_row_kernel (FracUseCPUExt cpu_ext, int pixels_size) {
+	switch (cpu_ext)
+	{
+		case FracUseCPUExt::AVX:
+			return frac_fill_index_row<FracUseCPUExt::AVX> (pixels_size);
+		case FracUseCPUExt::AVX_FMA:
+			return frac_fill_index_row<FracUseCPUExt::AVX_FMA> (pixels_size);
+		case FracUseCPUExt::AVX512:
+			return frac_fill_index_row<FracUseCPUExt::AVX512> (pixels_size);
+		default:
+			return frac_fill_index_row<FracUseCPUExt::None> (pixels_size);
+	}
+}
+
+/** Row kernel writing iteration counts, see frac_fill_count_row */
+inline fill_count_row_fn select_count_row_kernel (FracUseCPUExt cpu_ext, int pixels_size) {
+	switch (cpu_ext)
+	{
+		case FracUseCPUExt::AVX:
+			return frac_fill_count_row<FracUseCPUExt::AVX> (pixels_size);
+		case FracUseCPUExt::AVX_FMA:
+			return frac_fill_count_row<FracUseCPUExt::AVX_FMA> (pixels_size);
+		case FracUseCPUExt::AVX512:
+			return frac_fill_count_row<FracUseCPUExt::AVX512> (pixels_size);
+		default:
+			return frac_fill_count_row<FracUseCPUExt::None> (pixels_size);
+	}
+}
+
+/** Coloring pass of frames of iteration counts, see frac_color_frame */
+inline color_frame_fn select_color_kernel (FracUseCPUExt cpu_ext) {
+	switch (cpu_ext)
+	{
+		case FracUseCPUExt::AVX:
+			return frac_color_frame<FracUseCPUExt::AVX> ();
+		case FracUseCPUExt::AVX_FMA:
+			return frac_color_frame<FracUseCPUExt::AVX_FMA> ();
+		case FracUseCPUExt::AVX512:
+			return frac_color_frame<FracUseCPUExt::AVX512> ();
+		default:
+			return frac_color_frame<FracUseCPUExt::None> ();
+	}
+}
+
+/** Point kernel of an extension chosen at runtime, see frac_fill_points */
+inline fill_points_fn select_points_kernel (FracUseCPUExt cpu_ext, int pixels_size) {
+	switch (cpu_ext)
+	{
+		case FracUseCPUExt::AVX:
+			return frac_fill_points<FracUseCPUExt::AVX> (pixels_size);
+		case FracUseCPUExt::AVX_FMA:
+			return frac_fill_points<FracUseCPUExt::AVX_FMA> (pixels_size);
+		case FracUseCPUExt::AVX512:
+			return frac_fill_points<FracUseCPUExt::AVX512> (pixels_size);
+		default:
+			return frac_fill_points<FracUseCPUExt::None> (pixels_size);
+	}
+}
+
+/** Point kernel writing iteration counts, see frac_fill_count_points */
+inline fill_count_points_fn select_count_points_kernel (FracUseCPUExt cpu_ext, int pixels_size) {
+	switch (cpu_ext)
+	{
+		case FracUseCPUExt::AVX:
+			return frac_fill_count_points<FracUseCPUExt::AVX> (pixels_size);
+		case FracUseCPUExt::AVX_FMA:
+			return frac_fill_count_points<FracUseCPUExt::AVX_FMA> (pixels_size);
+		case FracUseCPUExt::AVX512:
+			return frac_fill_count_points<FracUseCPUExt::AVX512> (pixels_size);
+		default:
+			return frac_fill_count_points<FracUseCPUExt::None> (pixels_size);
+	}
+}
+
 void print_cpu_summary () {
 	std::cout << std::boolalpha;
 	std::cout << "CPU: " << std::endl;
@@ -28,37 +146,125 @@ void print_cpu_summary () {
 	std::cout << "  * Supports AVX?     : " << InstructionSet::AVX () << std::endl;
 	std::cout << "  * Supports AVX2?    : " << InstructionSet::AVX2 () << std::endl;
 	std::cout << "  * Supports FMA?     : " << InstructionSet::FMA () << std::endl;
+	std::cout << "  * Supports AVX-512F?: " << InstructionSet::AVX512F () << std::endl;
+	std::cout << "  * Selected kernel   : " << cpu_ext_name (detect_cpu_ext ()) << std::endl;
 }
 
-enum class FracUseCPUExt {
-	None,
-	AVX,
-	AVX_FMA
-};
-
 enum class FracProgress {
 	None,
 	Cout
 };
 
+/**
+Encoder threads started by FracCPU::start_encoders. Closes the ring and joins
+them when it goes out of scope, also when the rendering throws, so no joinable
+std::thread calls std::terminate. join rethrows the first exception one of the
+encoders threw, the encoders only release the frames after it.
+*/
+template<typename pixel_type>
+class EncoderThreads {
+	FrameRing<pixel_type>& _frames;
+	std::vector<std::thread> _threads;
+	std::atomic<bool> _failed{ false };
+	std::mutex _mutex;
+	std::exception_ptr _error;
+
+public:
+	explicit EncoderThreads (FrameRing<pixel_type>& frames)
+		: _frames{ frames } { }
+
+	// the encoders refer to it, so it can neither be copied nor moved
+	EncoderThreads (const EncoderThreads&) = delete;
+	EncoderThreads& operator= (const EncoderThreads&) = delete;
+
+	~EncoderThreads () {
+		stop ();
+	}
+
+	FrameRing<pixel_type>& frames () {
+		return _frames;
+	}
+
+	template<typename TFunc>
+	void add (TFunc&& encode) {
+		_threads.emplace_back (std::forward<TFunc> (encode));
+	}
+
+	/** Keeps the first exception of an encoder */
+	void fail (std::exception_ptr error) {
+		std::lock_guard<std::mutex> lock (_mutex);
+		if (!_error)
+			_error = error;
+		_failed = true;
+	}
+
+	bool failed () const {
+		return _failed;
+	}
+
+	/** Closes the ring, waits until the encoders drained it and rethrows the first exception one of them threw */
+	void join () {
+		stop ();
+		if (_error)
+			std::rethrow_exception (std::exchange (_error, nullptr));
+	}
+
+private:
+	void stop () {
+		_frames.close ();
+		for (auto& thread : _threads)
+		{
+			if (thread.joinable ())
+				thread.join ();
+		}
+	}
+};
+
 
 
+/** Samples of a row or column of pixels which FracCPU::average_taps averages */
+struct taps_t
+{
+	int count;
+	/** count samples per pixel, in order */
+	std::vector<int> samples;
+};
+
 /**
 Fractal Zoom implementation for CPU.
-Can use AVX and FMA extensions
+Can use AVX, FMA and AVX-512 extensions, by default the best one supported by
+the host is selected at runtime.
 */
 template<
-	FracUseCPUExt cpu_ext = FracUseCPUExt::AVX_FMA,
-	/** Defines how many pixels (multiplied by 8) are filled in a row */
+	FracUseCPUExt cpu_ext = FracUseCPUExt::Auto,
+	/** Defines how many pixels (multiplied by 8, or 16 with AVX-512) are filled in a row */
 	int pixels_size = 1,
 	FracProgress report_progress = FracProgress::Cout
 >
 class FracCPU {
+	static_assert (pixels_size == 1 || pixels_size == 2 || pixels_size == 4 || pixels_size == 8,
+		"pixels_size must be 1, 2, 4 or 8");
+
 protected:
 	std::string _name;
 	int _image_width;
 	int _image_height;
 	Timer _timer;
+	FracUseCPUExt _cpu_ext;
+	fill_row_fn _fill_row;
+	fill_index_row_fn _fill_index_row;
+	fill_count_row_fn _fill_count_row;
+	color_frame_fn _color_frame;
+	fill_points_fn _fill_points;
+	fill_count_points_fn _fill_count_points;
+	/** Per frame: pixels which were not iterated (interior check, filled rectangles) */
+	std::vector<size_t> _skipped_pixels;
+	/** Per frame: iterations every pixel skipped, see FractalZooming::frame_series */
+	std::vector<size_t> _series_iterations;
+	/** Get every frame in order, independent of FractalZooming::save_images */
+	std::vector<std::shared_ptr<FrameSink>> _sinks;
+	/** Renders into a FrameStore at this file instead of frames in memory unless it is empty */
+	std::string _store_file;
 
 public:
 	FracCPU (int image_width, int image_height)
@@ -66,48 +272,50 @@ public:
 
 protected:
 	FracCPU (int image_width, int image_height, std::string name)
-		: _image_width{ image_width }, _image_height{ image_height }, _name{ name } {
-		switch (cpu_ext)
-		{
-			case FracUseCPUExt::AVX:
-				_name += "+AVX";
-				break;
-			case FracUseCPUExt::AVX_FMA:
-				_name += "+AVX+FMA";
-				break;
-		}
-		_name += " (" + std::to_string (8 * pixels_size) + " pixels)";
+		: _name{ name }, _image_width{ image_width }, _image_height{ image_height },
+		_cpu_ext{ cpu_ext == FracUseCPUExt::Auto ? detect_cpu_ext () : cpu_ext } {
+		_fill_row = select_row_kernel (_cpu_ext, pixels_size);
+		_fill_index_row = select_index_row_kernel (_cpu_ext, pixels_size);
+		_fill_count_row = select_count_row_kernel (_cpu_ext, pixels_size);
+		_color_frame = select_color_kernel (_cpu_ext);
+		_fill_points = select_points_kernel (_cpu_ext, pixels_size);
+		_fill_count_points = select_count_points_kernel (_cpu_ext, pixels_size);
+		if (_cpu_ext != FracUseCPUExt::None)
+			_name += "+" + cpu_ext_name (_cpu_ext);
+		_name += " (" + std::to_string (vector_lanes (_cpu_ext) * pixels_size) + " pixels)";
 	}
 
 public:
 	void execute (const FractalZooming& zooming) {
-		std::vector<pixel_t> image(_image_width * _image_height);
+		// the frames are colors, in memory or in the store
+		if (zooming.frame_format != FractalZooming::FrameFormat::RGBA)
+			throw std::invalid_argument ("FracCPU only renders RGBA frames");
+		auto store = open_store (zooming);
+		std::vector<pixel_t> buffer(store ? 0 : _image_width * _image_height);
+		_skipped_pixels.assign (zooming.zoom_steps, 0);
+		_series_iterations.assign (zooming.zoom_steps, 0);
 
 		_timer.start ("all");
 
-		auto lower_left{ zooming.start_lower_left };
-		auto upper_right{ zooming.start_upper_right };
-
 		for (size_t i = 0; i < zooming.zoom_steps; i++)
 		{
-			auto scale = compute_scale (lower_left, upper_right, image);
+			complex_d_t lower_left, upper_right;
+			std::tie (lower_left, upper_right) = zooming.frame_bounds (i);
+			auto scale = compute_scale (lower_left, upper_right, _image_width, _image_height);
+			auto iterations = zooming.frame_iterations (i);
+			auto series = zooming.frame_series (lower_left, upper_right, scale, iterations);
+			_series_iterations[i] = series.skipped;
+			pixel_t* image = store ? store->frame (i) : buffer.data ();
 
 			// image starts at lower left conrer
-			for (size_t y = 0; y < image.height (); y++)
+			for (size_t y = 0; y < _image_height; y++)
 			{
-				fill_row (y, image, zooming, lower_left, scale);
-			}
-
-			if (zooming.save_images == FractalZooming::SaveImage::ToDisk) {
-				std::string file_name;
-				file_name += "frac_zoom_";
-				file_name += std::to_string (i);
-				file_name += ".bmp";
-
-				image.to_file (file_name);
+				_skipped_pixels[i] += fill_row (y, image, zooming, lower_left, scale, iterations, series);
 			}
 
-			zoom_and_re_center_inplace (lower_left, upper_right, zooming);
+			append_to_sinks (image);
+			if (store)
+				store->release (i, 1);
 		}
 
 		_timer.stop ();
@@ -117,365 +325,329 @@ public:
 		return _name;
 	}
 
-	const Timer& timer () const {
-		return _timer;
+	/** Streams the frames of the following executions to the sink as well */
+	void add_sink (std::shared_ptr<FrameSink> sink) {
+		_sinks.push_back (std::move (sink));
 	}
 
-protected:
-	std::map<size_t, std::tuple<complex_t, complex_t>> get_bounds (const FractalZooming& zooming) {
-		std::map<size_t, std::tuple<complex_t, complex_t>> bounds;
-		bounds[0] = std::make_tuple (zooming.start_lower_left, zooming.start_upper_right);
-		for (size_t i = 1; i < zooming.zoom_steps; i++)
-		{
-			bounds[i] = zoom_and_re_center (
-				std::get<0> (bounds[i - 1]),
-				std::get<1> (bounds[i - 1]),
-				zooming
-			);
-		}
-		return bounds;
+	/**
+	Renders the frames of the following executions into a FrameStore at
+	file_name instead of frames in memory, so the memory needed does not grow
+	with the resolution times the frames in flight. Empty renders into memory
+	again. Only the renderers which keep whole frames around use it (GPLS, GPLP
+	and the sequential one), the others keep a ring of a few frames and throw
+	std::invalid_argument when they execute with a store.
+	*/
+	void store_frames (std::string file_name) {
+		_store_file = std::move (file_name);
 	}
 
-	inline 
-	void fill_row (size_t y, std::vector<pixel_t>& image, const FractalZooming& zooming, const complex_t& lower_left, const std::array<float, 2>& scale) {
-		if constexpr (cpu_ext == FracUseCPUExt::AVX || cpu_ext == FracUseCPUExt::AVX_FMA) {
-			for (size_t x = 0; x < _image_width; x += 8 * pixels_size)
-			{
-				if constexpr (pixels_size == 1)
-					fill_8_pixels (x, y, image, zooming, lower_left, scale);
-				else
-					fill_pixels<pixels_size> (x, y, image, zooming, lower_left, scale);
-			}
-		}
-		else {
-			for (size_t x = 0; x < _image_width; x++)
-			{
-				auto idx = y * _image_width + x;
-				auto c = idx_to_complex (x, y, lower_left, scale);
-				auto result = mandelbrot (c);
-
-				image[idx] = get_color (result, zooming);
-			}
-		}
+	const Timer& timer () const {
+		return _timer;
 	}
 
-	inline 
-	void fill_8_pixels (size_t x, size_t y, std::vector<pixel_t>& image, const FractalZooming& zooming, const complex_t& lower_left, const std::array<float, 2>& scale) {
-		auto base_idx = y * _image_width + x;
-
-		__m256 c_real;
-		__m256 c_imag;
-		if constexpr (cpu_ext == FracUseCPUExt::AVX_FMA) {
-			auto c = idx_to_complex_8 (x, y, lower_left, scale);
-			c_real = std::get<0> (c);
-			c_imag = std::get<1> (c);
-		}
-		else {
-			auto c = std::array<complex_t, 8>{
-				idx_to_complex (x, y, lower_left, scale),
-				idx_to_complex (x + 1, y, lower_left, scale),
-				idx_to_complex (x + 2, y, lower_left, scale),
-				idx_to_complex (x + 3, y, lower_left, scale),
-				idx_to_complex (x + 4, y, lower_left, scale),
-				idx_to_complex (x + 5, y, lower_left, scale),
-				idx_to_complex (x + 6, y, lower_left, scale),
-				idx_to_complex (x + 7, y, lower_left, scale),
-			};
-			c_real = _mm256_set_ps (
-				std::get<7> (c).real, std::get<6> (c).real,
-				std::get<5> (c).real, std::get<4> (c).real,
-				std::get<3> (c).real, std::get<2> (c).real,
-				std::get<1> (c).real, std::get<0> (c).real
-			);
-			c_imag = _mm256_set_ps (
-				std::get<7> (c).imag, std::get<6> (c).imag,
-				std::get<5> (c).imag, std::get<4> (c).imag,
-				std::get<3> (c).imag, std::get<2> (c).imag,
-				std::get<1> (c).imag, std::get<0> (c).imag
-			);
-		}
-		auto result = mandelbrot_avx (c_real, c_imag);
-		auto span = image.pixel_span ();
-
-		span[base_idx] = get_color (std::get<0> (result), zooming);
-		span[base_idx + 1] = get_color (std::get<1> (result), zooming);
-		span[base_idx + 2] = get_color (std::get<2> (result), zooming);
-		span[base_idx + 3] = get_color (std::get<3> (result), zooming);
-		span[base_idx + 4] = get_color (std::get<4> (result), zooming);
-		span[base_idx + 5] = get_color (std::get<5> (result), zooming);
-		span[base_idx + 6] = get_color (std::get<6> (result), zooming);
-		span[base_idx + 7] = get_color (std::get<7> (result), zooming);
-	}
-
-	template<int size = 1>
-	inline
-	void fill_pixels (size_t x, size_t y, std::vector<pixel_t>& image, const FractalZooming& zooming, const complex_t& lower_left, const std::array<float, 2>& scale) {
-		std::array<__m256, size> c_real;
-		std::array<__m256, size> c_imag;
-
-		auto c = idx_to_complex_8 (x, y, lower_left, scale);
-		c_real[0] = std::get<0> (c);
-		c_imag.fill (std::get<1> (c)); // imag will be the same as we fill a row
-		for (size_t i = 1; i < size; i++)
-		{
-			c = idx_to_complex_8 (x + (i * 8), y, lower_left, scale);
-			c_real[i] = std::get<0> (c);
-		}
-		auto result = mandelbrot_avx_multiple<size> (c_real, c_imag);
-
-		auto base_idx = y * _image_width + x;
-		auto pixels_count = 8 * size;
-		auto overdraw = x + pixels_count < _image_width
-			? 0
-			: (x + pixels_count) - _image_width;
-
-		std::transform (
-			std::begin (result),
-			std::end (result) - overdraw,
-			std::begin (image) + base_idx,
-			[this, &zooming](auto& elem) { return get_color (elem, zooming); }
-		);
+	int image_width () const {
+		return _image_width;
 	}
 
-	inline
-	complex_t idx_to_complex (size_t x, size_t y, complex_t lower_left, std::array<float, 2> scale) {
-		return lower_left + complex_t{
-			x * std::get<0>(scale),
-			(_image_height - y - 1) * std::get<1>(scale)
-		};
+	int image_height () const {
+		return _image_height;
 	}
 
-	std::tuple<__m256, __m256> idx_to_complex_8 (size_t x, size_t y, complex_t lower_left, std::array<float, 2> scale) {
-		// real = lower_left.real + x * scale.x;
-		// imag = lower_left.imag + y * scale.y;
-		__m256 scale_real = _mm256_set1_ps (std::get<0>(scale));
-		__m256 ll_real = _mm256_set1_ps (lower_left.real());
-		__m256 xs = _mm256_add_ps (
-			_mm256_set1_ps ((float)x),
-			_mm256_set_ps (7, 6, 5, 4, 3, 2, 1, 0)
-		);
-
-		__m256 real = _mm256_fmadd_ps (xs, scale_real, ll_real);
-		__m256 imag = _mm256_set1_ps (
-			(_image_height - y - 1) * std::get<1>(scale) 
-			+ lower_left.imag()
-		); // y is fix as we calculate a 8 cols in a row
-
-		return std::make_tuple (real, imag);
+	const std::vector<size_t>& skipped_pixels () const {
+		return _skipped_pixels;
 	}
 
-	inline
-	pixel_t get_color (size_t iter_count, const FractalZooming& zooming) {
-		return zooming.color_map[iter_count];
+	const std::vector<size_t>& series_iterations () const {
+		return _series_iterations;
 	}
 
-	size_t mandelbrot (complex_t c) {
-		complex_t z;
-		for (size_t i = 0; i < FRACTAL_ITER; i++)
+protected:
+	/** Frames are handed to the sinks in order, call from one thread at a time */
+	void append_to_sinks (const pixel_t* frame) {
+		for (auto& sink : _sinks)
 		{
-			z = z * z + c;
-			auto mag = std::abs(z);
-			if (mag > FRACTAL_BOUND) { // divereged
-				return i;
-			}
+			sink->append_frame (frame, (size_t)_image_width * _image_height);
 		}
-		// bounded
-		return FRACTAL_ITER - 1;
 	}
 
-	std::array<size_t, 8> mandelbrot_avx (__m256 c_real, __m256 c_imag) {
-		// 8 32-bit float -> 4 complex numbers
-		__m256 const_2 = _mm256_set1_ps (2);
-		__m256 z_real = _mm256_set1_ps (0);
-		__m256 z_imag = _mm256_set1_ps (0);
+	/** The renderers keeping a ring of a few frames instead of whole frames have no store, see store_frames */
+	void reject_store () const {
+		if (!_store_file.empty ())
+			throw std::invalid_argument (_name + " renders into no FrameStore (store_frames was called with " + _store_file + ")");
+	}
 
-		std::array<size_t, 8> result;
-		result.fill (FRACTAL_ITER - 1);
-		for (size_t i = 0; i < FRACTAL_ITER; i++)
-		{
-			/*
-			z.real = z.real * z.real - z.imag * z.imag + c.real;
-			z.imag = 2 * z.real * z.imag + c.imag;
-			*/
-			__m256 prod = _mm256_mul_ps (z_real, z_imag);
-			z_real = _mm256_add_ps (
-				_mm256_sub_ps (
-					_mm256_mul_ps (z_real, z_real),
-					_mm256_mul_ps (z_imag, z_imag)
-				),
-				c_real
-			);
-
-			if constexpr (cpu_ext == FracUseCPUExt::AVX_FMA) {
-				z_imag = _mm256_fmadd_ps (prod, const_2, c_imag);
-			}
-			else {
-				z_imag = _mm256_add_ps (
-					_mm256_mul_ps (
-						prod,
-						const_2
-					),
-					c_imag
-				);
-			}
+	/** Store with room for every frame of zooming, if one was chosen with store_frames */
+	std::unique_ptr<FrameStore<>> open_store (const FractalZooming& zooming) const {
+		if (_store_file.empty ())
+			return nullptr;
+		return std::make_unique<FrameStore<>> (_store_file, _image_width, _image_height, zooming.zoom_steps);
+	}
 
-			__m256 mag = _mm256_add_ps (
-				_mm256_mul_ps (z_real, z_real),
-				_mm256_mul_ps (z_imag, z_imag)
-			);
-			for (size_t j = 0; j < 8; j++)
+	/**
+	Every pixel of the rows [y_begin, y_end) gets the average color of the
+	samples at the crossings of its column and row taps. The samples are
+	sample_width wide, their rows count from the top like the rows of the image.
+	*/
+	void average_taps (int y_begin, int y_end, const std::vector<iteration_count_t>& samples, int sample_width, const taps_t& columns, const taps_t& rows, const std::vector<pixel_t>& colors, std::vector<pixel_t>& frame) const {
+		const int count = columns.count * rows.count;
+		// one sample per pixel, it only has to be looked up
+		if (count == 1) {
+			for (int y = y_begin; y < y_end; y++)
 			{
-				if (((float*)&mag)[j] > FRACTAL_BOUND&& result[j] == FRACTAL_ITER - 1) {
-					result[j] = i;
+				const iteration_count_t* row = samples.data () + (size_t)rows.samples[y] * sample_width;
+				for (int x = 0; x < _image_width; x++)
+				{
+					frame[(size_t)y * _image_width + x] = colors[row[columns.samples[x]]];
 				}
 			}
-
-			bool all_diverged = std::all_of (
-				std::begin (result),
-				std::end (result),
-				[](const auto& e) {
-					return e < FRACTAL_BOUND - 1;
-				});
-			if (all_diverged)
-				return result;
-		}
-		return result;
-	}
-
-	template<int size = 1>
-	std::array<size_t, size * 8> mandelbrot_avx_multiple (std::array<__m256, size> c_real, std::array<__m256, size> c_imag) {
-		// 8 32-bit float -> 4 complex numbers
-		__m256 const_2 = _mm256_set1_ps (2);
-		std::array<__m256, size> z_real;
-		z_real.fill (_mm256_set1_ps (0));
-		std::array<__m256, size> z_imag;
-		z_imag.fill (_mm256_set1_ps (0));
-
-		std::array<size_t, size * 8> result;
-		result.fill (FRACTAL_ITER - 1);
-		for (size_t i = 0; i < FRACTAL_ITER; i++)
+			return;
+		}
+		// divides by count with a multiplication, exact for sums of up to 65536 colors
+		const std::uint64_t reciprocal = ((std::uint64_t{ 1 } << 40) + count - 1) / count;
+		auto average = [count, reciprocal](int sum) { return (unsigned char)(((std::uint64_t)(sum + count / 2) * reciprocal) >> 40); };
+		for (int y = y_begin; y < y_end; y++)
 		{
-			for (size_t j = 0; j < size; j++)
+			for (int x = 0; x < _image_width; x++)
 			{
-				/*
-				z.real = z.real * z.real - z.imag * z.imag + c.real;
-				z.imag = 2 * z.real * z.imag + c.imag;
-				*/
-				__m256 prod = _mm256_mul_ps (z_real[j], z_imag[j]);
-				z_real[j] = _mm256_add_ps (
-					_mm256_sub_ps (
-						_mm256_mul_ps (z_real[j], z_real[j]),
-						_mm256_mul_ps (z_imag[j], z_imag[j])
-					),
-					c_real[j]
-				);
-
-				if constexpr (cpu_ext == FracUseCPUExt::AVX_FMA) {
-					z_imag[j] = _mm256_fmadd_ps (prod, const_2, c_imag[j]);
-				}
-				else {
-					z_imag[j] = _mm256_add_ps (
-						_mm256_mul_ps (
-							prod,
-							const_2
-						),
-						c_imag[j]
-					);
+				int r = 0, g = 0, b = 0, a = 0;
+				for (int ty = 0; ty < rows.count; ty++)
+				{
+					const iteration_count_t* row = samples.data () + (size_t)rows.samples[(size_t)y * rows.count + ty] * sample_width;
+					for (int tx = 0; tx < columns.count; tx++)
+					{
+						const pixel_t& color = colors[row[columns.samples[(size_t)x * columns.count + tx]]];
+						r += color.r;
+						g += color.g;
+						b += color.b;
+						a += color.a;
+					}
 				}
+				frame[(size_t)y * _image_width + x] = pixel_t{ average (r), average (g), average (b), average (a) };
+			}
+		}
+	}
 
-				__m256 mag = _mm256_add_ps (
-					_mm256_mul_ps (z_real[j], z_real[j]),
-					_mm256_mul_ps (z_imag[j], z_imag[j])
-				);
-				for (size_t k = 0; k < 8; k++)
-				{
-					if (((float*)&mag)[k] > FRACTAL_BOUND&& result[(j * 8) + k] == FRACTAL_ITER - 1) {
-						result[(j * 8) + k] = i;
+	/**
+	Appends the frames published to the ring of encoders to the gif (unless it
+	is nullptr) and the sinks on encoder_count threads of their own, so the next
+	frames render while several are encoded. Each thread encodes a whole frame
+	into memory and writes it once the frames before it are written. Stops once
+	the ring is closed, see EncoderThreads.
+	*/
+	template<typename pixel_type>
+	void start_encoders (EncoderThreads<pixel_type>& encoders, AnimatedGif* image, const FractalZooming& zooming, std::chrono::milliseconds delay, size_t encoder_count) {
+		for (size_t e = 0; e < encoder_count; e++)
+		{
+			encoders.add ([this, image, &encoders, &frames = encoders.frames (), &zooming, delay]() {
+				auto encoded = image ? std::make_unique<AnimatedGif::EncodedFrame> (_image_width, _image_height) : nullptr;
+				auto frame_delay = std::chrono::duration_cast<std::chrono::duration<short, std::centi>>(delay);
+				auto palette = zooming.palette ();
+				// frames of counts go to the gif as palette indices and to the sinks as colors
+				std::vector<palette_index_t> count_palette_index;
+				std::vector<palette_index_t> indices;
+				std::vector<pixel_t> colored;
+				if constexpr (std::is_same_v<pixel_type, iteration_count_t>) {
+					count_palette_index.resize (zooming.colors ().size ());
+					for (size_t c = 0; c < count_palette_index.size (); c++)
+					{
+						count_palette_index[c] = zooming.palette_index (c);
 					}
 				}
+				while (auto index = frames.next ())
+				{
+					const std::vector<pixel_type>& frame = frames.frame (*index);
+					// after an encoder failed the frames are only released
+					try {
+						if (!encoders.failed ()) {
+							if constexpr (std::is_same_v<pixel_type, iteration_count_t>) {
+								if (image) {
+									indices.resize (frame.size ());
+									std::transform (std::begin (frame), std::end (frame), std::begin (indices),
+										[&count_palette_index](iteration_count_t count) { return count_palette_index[count]; });
+									image->encode_frame (*encoded, indices.data (), indices.size (), frame_delay);
+								}
+								if (!_sinks.empty ()) {
+									colored.resize (frame.size ());
+									_color_frame (frame.data (), frame.size (), zooming.colors ().data (), colored.data ());
+								}
+							}
+							else if (image) {
+								if constexpr (std::is_same_v<pixel_type, palette_index_t>)
+									image->encode_frame (*encoded, frame.data (), frame.size (), frame_delay);
+								else
+									image->encode_frame (*encoded, *index, frame.data (), frame.size (), frame_delay, true);
+							}
+						}
+					}
+					catch (...) {
+						encoders.fail (std::current_exception ());
+					}
 
-				bool all_diverged = std::all_of (
-					std::begin (result),
-					std::end (result),
-					[](const auto& e) { return e < FRACTAL_BOUND - 1; });
-				if (all_diverged)
-					return result;
-			}
+					// frames are written in order, so they are released in order too
+					frames.wait_for_turn (*index);
+					try {
+						if (!encoders.failed ()) {
+							if (image)
+								image->write_frame (*index, *encoded);
+							for (auto& sink : _sinks)
+							{
+								if constexpr (std::is_same_v<pixel_type, palette_index_t>)
+									sink->append_frame (frame, palette);
+								else if constexpr (std::is_same_v<pixel_type, iteration_count_t>)
+									sink->append_frame (colored);
+								else
+									sink->append_frame (frame);
+							}
+						}
+					}
+					catch (...) {
+						encoders.fail (std::current_exception ());
+					}
+					frames.release ();
+				}
+			});
 		}
-		return result;
 	}
 
-	size_t julia (complex_t z) {
-		complex_t c{ -0.8f, 0.156f };
-		for (size_t i = 0; i < FRACTAL_ITER; i++)
+	/** Frames of palette indices or counts use the palette of the color map, colored frames get one learned per frame */
+	template<typename pixel_type>
+	AnimatedGif open_gif (const std::string& file_name, const FractalZooming& zooming) const {
+		if constexpr (!std::is_same_v<pixel_type, pixel_t>)
+			return AnimatedGif (file_name, _image_width, _image_height, zooming.palette ());
+		else
+			return AnimatedGif (file_name, _image_width, _image_height);
+	}
+
+	inline
+	size_t fill_row (size_t y, pixel_t* image, const FractalZooming& zooming, const complex_d_t& lower_left, const std::array<double, 2>& scale, size_t iterations, const series_t& series) {
+		return _fill_row (y, y + 1, 0, _image_width, image, zooming, lower_left, scale, iterations, series, _image_width, _image_height);
+	}
+
+	/** One call for the whole tile, a kernel call per row of a narrow tile costs ~25% */
+	template<typename pixel_type>
+	inline
+	size_t fill_tile (const TileScheduler::tile_t& tile, pixel_type* image, const FractalZooming& zooming, const complex_d_t& lower_left, const std::array<double, 2>& scale, size_t iterations, const series_t& series) {
+		if constexpr (std::is_same_v<pixel_type, palette_index_t>)
+			return _fill_index_row (tile.y0, tile.y1, tile.x0, tile.x1, image, zooming, lower_left, scale, iterations, series, _image_width, _image_height);
+		else if constexpr (std::is_same_v<pixel_type, iteration_count_t>)
+			return _fill_count_row (tile.y0, tile.y1, tile.x0, tile.x1, image, zooming, lower_left, scale, iterations, series, _image_width, _image_height);
+		else
+			return _fill_row (tile.y0, tile.y1, tile.x0, tile.x1, image, zooming, lower_left, scale, iterations, series, _image_width, _image_height);
+	}
+
+	/** Tile width rounded up to the pixels the row kernel fills at once, so no vector crosses a tile */
+	int kernel_tile_width (int tile_width) const {
+		int kernel_width = vector_lanes (_cpu_ext) * pixels_size;
+		return (std::max (tile_width, 1) + kernel_width - 1) / kernel_width * kernel_width;
+	}
+
+	/** Renders the tiles handed out by the scheduler until none are left, records their cost */
+	template<typename pixel_type>
+	size_t fill_scheduled_tiles (TileScheduler& scheduler, pixel_type* image, const FractalZooming& zooming, const complex_d_t& lower_left, const std::array<double, 2>& scale, size_t iterations, const series_t& series) {
+		size_t skipped = 0;
+		for (size_t t = scheduler.next (); t != TileScheduler::no_tile; t = scheduler.next ())
 		{
-			z = z.square () + c;
-			auto mag = z.norm ();
-			if (mag > FRACTAL_BOUND) { // divereged - not in set
-				return i;
-			}
+			auto start = TileScheduler::Clock::now ();
+			skipped += fill_tile (scheduler.tile (t), image, zooming, lower_left, scale, iterations, series);
+			scheduler.set_cost (t, TileScheduler::Clock::now () - start);
 		}
-		// bounded - in set
-		return FRACTAL_ITER - 1;
+		return skipped;
+	}
+
+	inline
+	size_t fill_points (const std::vector<size_t>& points, std::vector<pixel_t>& image, const FractalZooming& zooming, const complex_d_t& lower_left, const std::array<double, 2>& scale, size_t iterations, const series_t& series) {
+		return _fill_points (points, image, zooming, lower_left, scale, iterations, series, _image_width, _image_height);
 	}
 };
 
 template<
-	FracUseCPUExt cpu_ext = FracUseCPUExt::AVX_FMA,
+	FracUseCPUExt cpu_ext = FracUseCPUExt::Auto,
 	int pixels_size = 1,
 	FracProgress report_progress = FracProgress::Cout,
-	typename parallelizer = typename task_group
+	typename parallelizer = pool_group
 >
-class FracCPU_GSLP : public FracCPU<cpu_ext, pixels_size> {
+class FracCPU_GSLP : public FracCPU<cpu_ext, pixels_size, report_progress> {
+	using Base = FracCPU<cpu_ext, pixels_size, report_progress>;
+	using Base::_image_width;
+	using Base::_image_height;
+	using Base::_timer;
+	using Base::fill_scheduled_tiles;
+	using Base::kernel_tile_width;
+	using Base::_skipped_pixels;
+	using Base::_series_iterations;
+	using Base::start_encoders;
+	using Base::_sinks;
+	using Base::reject_store;
 	size_t _task_count;
+	int _tile_width;
+	int _tile_height;
+	/** Frame buffers shared by the renderer and the encoders, one encoder less than buffers */
+	size_t _frames_in_flight;
 
 public:
-	FracCPU_GSLP (int image_width, int image_height, size_t task_count)
-		: FracCPU (image_width, image_height, "FracCPU_GSLP using " + std::string (typeid(parallelizer).name ()) + " (" + std::to_string (task_count) + ")"), _task_count{ task_count } { }
+	FracCPU_GSLP (int image_width, int image_height, size_t task_count, int tile_width = 64, int tile_height = 16, size_t frames_in_flight = 3)
+		: Base (image_width, image_height, "FracCPU_GSLP using " + std::string (typeid(parallelizer).name ()) + " (" + std::to_string (task_count) + ", " + std::to_string (tile_width) + "x" + std::to_string (tile_height) + " tiles)"), _task_count{ task_count },
+		_tile_width{ kernel_tile_width (tile_width) }, _tile_height{ tile_height }, _frames_in_flight{ std::max<size_t> (frames_in_flight, 1) } { }
 
 	void execute (const FractalZooming& zooming) {
-		AnimatedGif image("zoom.gif", _image_width, _image_height);
+		reject_store ();
+		if (zooming.frame_format == FractalZooming::FrameFormat::PaletteIndices)
+			render<palette_index_t> (zooming);
+		else if (zooming.frame_format == FractalZooming::FrameFormat::IterationCounts)
+			render<iteration_count_t> (zooming);
+		else
+			render<pixel_t> (zooming);
+	}
+
+private:
+	/** Renders the frames as colors (pixel_t), palette indices (palette_index_t) or iteration counts (iteration_count_t) */
+	template<typename pixel_type>
+	void render (const FractalZooming& zooming) {
+		if (std::is_same_v<pixel_type, iteration_count_t> && zooming.colors ().size () > (size_t)std::numeric_limits<iteration_count_t>::max () + 1)
+			throw std::invalid_argument ("iteration counts address at most 65536 colors (there are " + std::to_string (zooming.colors ().size ()) + ")");
+
+		AnimatedGif image = this->template open_gif<pixel_type> ("zoom.gif", zooming);
 		auto delay = 33ms;
-		std::vector<pixel_t> frame(_image_width * _image_height);
+		FrameRing<pixel_type> frames{ _frames_in_flight, (size_t)_image_width * _image_height };
+		std::vector<size_t> skipped(_task_count);
+		_skipped_pixels.assign (zooming.zoom_steps, 0);
+		_series_iterations.assign (zooming.zoom_steps, 0);
+		TileScheduler scheduler{ _image_width, _image_height, _tile_width, _tile_height };
 
 		_timer.start ("all");
 
-		const size_t partition_size = _image_height / _task_count;
-		const size_t partition_remainder = _image_height % _task_count;
-
-		auto lower_left{ zooming.start_lower_left };
-		auto upper_right{ zooming.start_upper_right };
+		const bool save_gif = zooming.save_images == FractalZooming::SaveImage::ToDisk;
+		const bool save = save_gif || !_sinks.empty ();
+		EncoderThreads encoders{ frames };
+		if (save)
+			start_encoders (encoders, save_gif ? &image : nullptr, zooming, delay, std::max<size_t> (_frames_in_flight - 1, 1));
 
 		for (size_t i = 0; i < zooming.zoom_steps; i++)
 		{
-			parallelizer parallelizer;
+			parallelizer group;
+			std::vector<pixel_type>& frame = frames.acquire ();
+			complex_d_t lower_left, upper_right;
+			std::tie (lower_left, upper_right) = zooming.frame_bounds (i);
 			auto scale = compute_scale (lower_left, upper_right, _image_width, _image_height);
+			auto iterations = zooming.frame_iterations (i);
+			auto series = zooming.frame_series (lower_left, upper_right, scale, iterations);
+			_series_iterations[i] = series.skipped;
 
+			scheduler.begin_frame ();
 			for (size_t p = 0; p < _task_count; p++)
 			{
-				size_t start = p * partition_size;
-				size_t end = (p + 1) * partition_size;
-				if (p == _task_count - 1)
-					end += partition_remainder;
-
-				parallelizer.add ([this, &frame, &lower_left, &scale, &zooming](size_t start, size_t end) {
-					for (size_t y = start; y < end; y++)
-					{
-						fill_row (y, frame, zooming, lower_left, scale);
-					}}, start, end);
+				group.add ([this, &frame, &scheduler, &frame_skipped = skipped[p], &lower_left, &scale, iterations, &series, &zooming]() {
+					frame_skipped = fill_scheduled_tiles (scheduler, frame.data (), zooming, lower_left, scale, iterations, series);
+					});
 			}
 
-			zoom_and_re_center_inplace (lower_left, upper_right, zooming);
-
-			parallelizer.join_all ();
+			group.join_all ();
+			_skipped_pixels[i] = std::accumulate (std::begin (skipped), std::end (skipped), size_t{ 0 });
 
-			if (zooming.save_images == FractalZooming::SaveImage::ToDisk) {
-				// image.to_file (file_name);
-				image.append_frame(frame,
-					std::chrono::duration_cast<std::chrono::duration<short, std::centi>>(delay), 
-					true
-				);
-			}
+			// without encoders the same buffer is rendered again
+			if (save)
+				frames.publish ();
 
 			if (report_progress == FracProgress::Cout && i % 10 == 0) {
 				std::cout << i << " ";
@@ -483,69 +655,88 @@ public:
 		}
 		if (report_progress == FracProgress::Cout) std::cout << std::endl;
 
+		encoders.join ();
+
 		_timer.stop ();
 	}
 };
 
 template<
-	FracUseCPUExt cpu_ext = FracUseCPUExt::AVX_FMA,
+	FracUseCPUExt cpu_ext = FracUseCPUExt::Auto,
 	int pixels_size = 1,
 	FracProgress report_progress = FracProgress::Cout,
-	typename parallelizer = typename thread_group
+	typename parallelizer = pool_group
 >
-class FracCPU_GPLS : public FracCPU<cpu_ext, pixels_size> {
+class FracCPU_GPLS : public FracCPU<cpu_ext, pixels_size, report_progress> {
+	using Base = FracCPU<cpu_ext, pixels_size, report_progress>;
+	using Base::_image_width;
+	using Base::_image_height;
+	using Base::_timer;
+	using Base::fill_row;
+	using Base::_skipped_pixels;
+	using Base::_series_iterations;
+	using Base::append_to_sinks;
+	using Base::open_store;
 	size_t _task_count;
 
 public:
 	FracCPU_GPLS (int image_width, int image_height, size_t task_count)
-		: FracCPU (image_width, image_height, "FracCPU_GPLS using " + std::string (typeid(parallelizer).name ()) + "(" + std::to_string (task_count) + ")"), _task_count{ task_count } { }
+		: Base (image_width, image_height, "FracCPU_GPLS using " + std::string (typeid(parallelizer).name ()) + "(" + std::to_string (task_count) + ")"), _task_count{ task_count } { }
 
 	void execute (const FractalZooming& zooming) {
+		// the frames are colors, in memory or in the store
+		if (zooming.frame_format != FractalZooming::FrameFormat::RGBA)
+			throw std::invalid_argument ("FracCPU_GPLS only renders RGBA frames");
+		auto store = open_store (zooming);
 		std::vector<std::vector<pixel_t>> images;
-		for (size_t i = 0; i < _task_count; i++)
+		for (size_t i = 0; !store && i < _task_count; i++)
 		{
 			images.emplace_back (_image_width * _image_height);
 		}
+		_skipped_pixels.assign (zooming.zoom_steps, 0);
+		_series_iterations.assign (zooming.zoom_steps, 0);
 
 		_timer.start ("all");
 
 		size_t i = 0;
-		std::map<size_t, std::tuple<complex_t, complex_t>> bounds{ get_bounds (zooming) };
 		while (i < zooming.zoom_steps)
 		{
-			parallelizer parallelizer;
+			parallelizer group;
 
+			auto start_i = i;
 			for (size_t t = 0; t < _task_count; t++)
 			{
-				if (i > zooming.zoom_steps)
+				if (i >= zooming.zoom_steps)
 					break;
 
-				parallelizer.add ([this, t, i, &bounds, &images, &zooming]() {
-					std::vector<pixel_t>& image{ images[t] };
+				group.add ([this, t, i, &images, &store, &zooming]() {
+					pixel_t* image = store ? store->frame (i) : images[t].data ();
 
-					auto bound = bounds[i];
+					auto bound = zooming.frame_bounds (i);
 					auto lower_left = std::get<0> (bound);
 					auto scale = compute_scale (lower_left, std::get<1> (bound), _image_width, _image_height);
+					auto iterations = zooming.frame_iterations (i);
+					auto series = zooming.frame_series (lower_left, std::get<1> (bound), scale, iterations);
+					_series_iterations[i] = series.skipped;
 
+					size_t skipped = 0;
 					for (size_t y = 0; y < _image_height; y++)
 					{
-						fill_row (y, image, zooming, lower_left, scale);
-					}
-
-					if (zooming.save_images == FractalZooming::SaveImage::ToDisk) {
-						std::string file_name;
-						file_name += "frac_zoom_";
-						file_name += std::to_string (i);
-						file_name += ".bmp";
-
-						// image.to_file (file_name);
+						skipped += fill_row (y, image, zooming, lower_left, scale, iterations, series);
 					}
+					_skipped_pixels[i] = skipped;
 					});
 
 				i++;
 			}
 
-			parallelizer.join_all ();
+			group.join_all ();
+			for (size_t t = 0; t < i - start_i; t++)
+			{
+				append_to_sinks (store ? store->frame (start_i + t) : images[t].data ());
+			}
+			if (store)
+				store->release (start_i, i - start_i);
 
 			if (report_progress == FracProgress::Cout && i % _task_count == 0) {
 				std::cout << i << " ";
@@ -558,84 +749,826 @@ public:
 };
 
 template<
-	FracUseCPUExt cpu_ext = FracUseCPUExt::AVX_FMA,
+	FracUseCPUExt cpu_ext = FracUseCPUExt::Auto,
 	int pixels_size = 1,
 	FracProgress report_progress = FracProgress::Cout,
-	typename parallelizer = typename task_group
+	typename parallelizer = pool_group
 >
-class FracCPU_GPLP : public FracCPU<cpu_ext, pixels_size> {
+class FracCPU_GPLP : public FracCPU<cpu_ext, pixels_size, report_progress> {
+	using Base = FracCPU<cpu_ext, pixels_size, report_progress>;
+	using Base::_image_width;
+	using Base::_image_height;
+	using Base::_timer;
+	using Base::fill_scheduled_tiles;
+	using Base::kernel_tile_width;
+	using Base::_skipped_pixels;
+	using Base::_series_iterations;
+	using Base::append_to_sinks;
+	using Base::open_store;
 	size_t _image_count;
 	size_t _task_count;
+	int _tile_width;
+	int _tile_height;
 
 public:
-	FracCPU_GPLP (int image_width, int image_height, size_t image_count, size_t task_count)
-		: FracCPU (image_width, image_height, "FracCPU_GPLP using " + std::string(typeid(parallelizer).name ()) + " (" + std::to_string (image_count) + "/" + std::to_string (task_count) + ")"), _image_count{ image_count }, _task_count{ task_count } { }
+	FracCPU_GPLP (int image_width, int image_height, size_t image_count, size_t task_count, int tile_width = 64, int tile_height = 16)
+		: Base (image_width, image_height, "FracCPU_GPLP using " + std::string(typeid(parallelizer).name ()) + " (" + std::to_string (image_count) + "/" + std::to_string (task_count) + ", " + std::to_string (tile_width) + "x" + std::to_string (tile_height) + " tiles)"), _image_count{ image_count }, _task_count{ task_count },
+		_tile_width{ kernel_tile_width (tile_width) }, _tile_height{ tile_height } { }
 
 	void execute (const FractalZooming& zooming) {
-		const size_t partition_size = _image_height / _task_count;
-		const size_t partition_remainder = _image_height % _task_count;
-
+		// the frames are colors, in memory or in the store
+		if (zooming.frame_format != FractalZooming::FrameFormat::RGBA)
+			throw std::invalid_argument ("FracCPU_GPLP only renders RGBA frames");
+		auto store = open_store (zooming);
 		std::vector<std::vector<pixel_t>> images;
+		// the costs of an image slot come from the frame rendered in it before
+		std::deque<TileScheduler> schedulers;
 		for (size_t i = 0; i < _image_count; i++)
 		{
-			images.emplace_back (_image_width * _image_height);
+			if (!store)
+				images.emplace_back (_image_width * _image_height);
+			schedulers.emplace_back (_image_width, _image_height, _tile_width, _tile_height);
 		}
+		std::vector<size_t> skipped(_image_count * _task_count);
+		_skipped_pixels.assign (zooming.zoom_steps, 0);
+		_series_iterations.assign (zooming.zoom_steps, 0);
 
 		_timer.start ("all");
 
 		size_t i = 0;
-		std::map<size_t, std::tuple<complex_t, complex_t>> bounds{ get_bounds (zooming) };
 		while (i < zooming.zoom_steps)
 		{
-			parallelizer parallelizer;
+			parallelizer group;
 
 			auto start_i = i;
+			std::fill (std::begin (skipped), std::end (skipped), 0);
 			for (size_t j = 0; j < _image_count; j++)
 			{
-				if (i > zooming.zoom_steps)
+				if (i >= zooming.zoom_steps)
 					break;
 
-				std::vector<pixel_t>& image{ images[j] };
-				auto bound = bounds[i];
+				pixel_t* image = store ? store->frame (i) : images[j].data ();
+				TileScheduler& scheduler{ schedulers[j] };
+				auto bound = zooming.frame_bounds (i);
 				auto lower_left = std::get<0> (bound);
 				auto scale = compute_scale (lower_left, std::get<1> (bound), _image_width, _image_height);
+				auto iterations = zooming.frame_iterations (i);
+				auto series = zooming.frame_series (lower_left, std::get<1> (bound), scale, iterations);
+				_series_iterations[i] = series.skipped;
+				scheduler.begin_frame ();
 				for (size_t k = 0; k < _task_count; k++)
 				{
-					size_t start = k * partition_size;
-					size_t end = (k + 1) * partition_size;
-					if (k == _task_count - 1)
-						end += partition_remainder;
-
-					parallelizer.add ([this, &image, lower_left, scale, &zooming](size_t start, size_t end) {
-						for (size_t y = start; y < end; y++)
-						{
-							fill_row (y, image, zooming, lower_left, scale);
-						}}, start, end);
+					group.add ([this, image, &scheduler, &frame_skipped = skipped[j * _task_count + k], lower_left, scale, iterations, series, &zooming]() {
+						frame_skipped = fill_scheduled_tiles (scheduler, image, zooming, lower_left, scale, iterations, series);
+						});
 				}
 
 				i++;
 			}
 
-			parallelizer.join_all ();
+			group.join_all ();
+			for (size_t j = 0; j < _image_count && start_i + j < zooming.zoom_steps; j++)
+			{
+				_skipped_pixels[start_i + j] = std::accumulate (
+					std::begin (skipped) + j * _task_count,
+					std::begin (skipped) + (j + 1) * _task_count,
+					size_t{ 0 });
+			}
+
+			for (size_t j = 0; j < _image_count && start_i + j < zooming.zoom_steps; j++)
+			{
+				append_to_sinks (store ? store->frame (start_i + j) : images[j].data ());
+			}
+			if (store)
+				store->release (start_i, i - start_i);
 
-			if (zooming.save_images == FractalZooming::SaveImage::ToDisk) {
-				for (size_t j = 0; j < _image_count && start_i + j < zooming.zoom_steps; j++)
-				{
-					std::string file_name;
-					file_name += "frac_zoom_";
-					file_name += std::to_string (start_i + j);
-					file_name += ".bmp";
+			if (report_progress == FracProgress::Cout && i % _image_count == 0) {
+				std::cout << i << " ";
+			}
+		}
+		if (report_progress == FracProgress::Cout) std::cout << std::endl;
+
+		_timer.stop ();
+	}
+};
+
+/**
+Mariani-Silver rendering: every frame is split into tiles which are rendered in
+parallel. Only the border of a rectangle is computed, if it has a single color
+the inside gets that color as well, otherwise the rectangle is split in two and
+the dividing line is computed. Small rectangles are computed pixel by pixel.
+
+This is exact as long as no filament of the set passes through a rectangle
+without touching its border, which holds for all but the smallest details.
+The borders are computed with the point kernel, pixels_size vectors at a time.
+*/
+template<
+	FracUseCPUExt cpu_ext = FracUseCPUExt::Auto,
+	int pixels_size = 1,
+	FracProgress report_progress = FracProgress::Cout,
+	typename parallelizer = pool_group
+>
+class FracCPU_MS : public FracCPU<cpu_ext, pixels_size, report_progress> {
+	using Base = FracCPU<cpu_ext, pixels_size, report_progress>;
+	using Base::_image_width;
+	using Base::_image_height;
+	using Base::_timer;
+	using Base::fill_points;
+	using Base::_skipped_pixels;
+	using Base::_series_iterations;
+	using Base::start_encoders;
+	using Base::_sinks;
+	using Base::reject_store;
+	size_t _task_count;
+	int _tile_size;
+	/** Frame buffers shared by the renderer and the encoders, one encoder less than buffers */
+	size_t _frames_in_flight;
+
+	/** Rectangle of pixels, the bounds are inclusive */
+	struct rect_t {
+		int x0, y0, x1, y1;
+	};
+
+	/** Rectangles with fewer pixels inside are not divided any further */
+	static constexpr int min_size = 4;
+
+public:
+	FracCPU_MS (int image_width, int image_height, size_t task_count, int tile_size = 64, size_t frames_in_flight = 3)
+		: Base (image_width, image_height, "FracCPU_MS using " + std::string (typeid(parallelizer).name ()) + " (" + std::to_string (task_count) + ", " + std::to_string (tile_size) + "px tiles)"), _task_count{ task_count }, _tile_size{ tile_size },
+		_frames_in_flight{ std::max<size_t> (frames_in_flight, 1) } { }
+
+	void execute (const FractalZooming& zooming) {
+		// the point kernels only write colors
+		if (zooming.frame_format != FractalZooming::FrameFormat::RGBA)
+			throw std::invalid_argument ("FracCPU_MS only renders RGBA frames");
+		reject_store ();
+
+		AnimatedGif image("zoom.gif", _image_width, _image_height);
+		auto delay = 33ms;
+		FrameRing frames{ _frames_in_flight, (size_t)_image_width * _image_height };
+		std::vector<size_t> skipped(_task_count);
+		_skipped_pixels.assign (zooming.zoom_steps, 0);
+		_series_iterations.assign (zooming.zoom_steps, 0);
+
+		std::vector<rect_t> tiles;
+		for (int y = 0; y < _image_height; y += _tile_size)
+		{
+			for (int x = 0; x < _image_width; x += _tile_size)
+			{
+				tiles.push_back ({ x, y,
+					std::min (x + _tile_size, _image_width) - 1,
+					std::min (y + _tile_size, _image_height) - 1 });
+			}
+		}
+
+		_timer.start ("all");
+
+		const bool save_gif = zooming.save_images == FractalZooming::SaveImage::ToDisk;
+		const bool save = save_gif || !_sinks.empty ();
+		EncoderThreads encoders{ frames };
+		if (save)
+			start_encoders (encoders, save_gif ? &image : nullptr, zooming, delay, std::max<size_t> (_frames_in_flight - 1, 1));
+
+		for (size_t i = 0; i < zooming.zoom_steps; i++)
+		{
+			parallelizer group;
+			std::vector<pixel_t>& frame = frames.acquire ();
+			complex_d_t lower_left, upper_right;
+			std::tie (lower_left, upper_right) = zooming.frame_bounds (i);
+			auto scale = compute_scale (lower_left, upper_right, _image_width, _image_height);
+			auto iterations = zooming.frame_iterations (i);
+			auto series = zooming.frame_series (lower_left, upper_right, scale, iterations);
+			_series_iterations[i] = series.skipped;
+
+			// tasks take every task_count-th tile, so the costly tiles are spread evenly
+			for (size_t p = 0; p < _task_count; p++)
+			{
+				group.add ([this, &frame, &tiles, &frame_skipped = skipped[p], &lower_left, &scale, iterations, &series, &zooming](size_t first) {
+					frame_skipped = fill_tiles (first, tiles, frame, zooming, lower_left, scale, iterations, series);
+					}, p);
+			}
+
+			group.join_all ();
+			_skipped_pixels[i] = std::accumulate (std::begin (skipped), std::end (skipped), size_t{ 0 });
+
+			if (save)
+				frames.publish ();
+
+			if (report_progress == FracProgress::Cout && i % 10 == 0) {
+				std::cout << i << " ";
+			}
+		}
+		if (report_progress == FracProgress::Cout) std::cout << std::endl;
+
+		encoders.join ();
+
+		_timer.stop ();
+	}
+
+private:
+	size_t idx (int x, int y) const {
+		return (size_t)y * _image_width + x;
+	}
+
+	/**
+	Renders every task_count-th tile starting at first. All rectangles of one
+	subdivision level are computed with a single call of the point kernel, so
+	the short dividing lines still fill whole vectors.
+	Returns the pixels which were not iterated.
+	*/
+	size_t fill_tiles (size_t first, const std::vector<rect_t>& tiles, std::vector<pixel_t>& frame, const FractalZooming& zooming, const complex_d_t& lower_left, const std::array<double, 2>& scale, size_t iterations, const series_t& series) {
+		std::vector<rect_t> rects;
+		std::vector<rect_t> divided;
+		std::vector<size_t> points;
+		for (size_t t = first; t < tiles.size (); t += _task_count)
+		{
+			rects.push_back (tiles[t]);
+			add_border (tiles[t], points);
+		}
+		size_t skipped = fill_points (points, frame, zooming, lower_left, scale, iterations, series);
+
+		while (!rects.empty ())
+		{
+			points.clear ();
+			divided.clear ();
+			for (const auto& rect : rects)
+			{
+				skipped += divide (rect, frame, points, divided);
+			}
+			skipped += fill_points (points, frame, zooming, lower_left, scale, iterations, series);
+			std::swap (rects, divided);
+		}
+		return skipped;
+	}
+
+	/** One edge after the other, so neighbouring lanes need similar iteration counts */
+	void add_border (rect_t rect, std::vector<size_t>& points) const {
+		for (int y : { rect.y0, rect.y1 })
+		{
+			for (int x = rect.x0; x <= rect.x1; x++)
+			{
+				points.push_back (idx (x, y));
+			}
+			if (rect.y1 == rect.y0)
+				break;
+		}
+		for (int x : { rect.x0, rect.x1 })
+		{
+			for (int y = rect.y0 + 1; y < rect.y1; y++)
+			{
+				points.push_back (idx (x, y));
+			}
+			if (rect.x1 == rect.x0)
+				break;
+		}
+	}
+
+	/**
+	The border of rect is already computed. Fills the inside if the border has a
+	single color, otherwise adds the points to compute next to points and the
+	halves to divided. Returns the number of filled pixels.
+	*/
+	size_t divide (rect_t rect, std::vector<pixel_t>& frame, std::vector<size_t>& points, std::vector<rect_t>& divided) const {
+		int inner_width = rect.x1 - rect.x0 - 1;
+		int inner_height = rect.y1 - rect.y0 - 1;
+		if (inner_width <= 0 || inner_height <= 0)
+			return 0;
+
+		const pixel_t color = frame[idx (rect.x0, rect.y0)];
+		if (border_has_color (rect, frame, color)) {
+			for (int y = rect.y0 + 1; y < rect.y1; y++)
+			{
+				std::fill_n (std::begin (frame) + idx (rect.x0 + 1, y), inner_width, color);
+			}
+			return (size_t)inner_width * inner_height;
+		}
 
-					// images[j].to_file (file_name);
+		if (inner_width <= min_size || inner_height <= min_size) {
+			for (int y = rect.y0 + 1; y < rect.y1; y++)
+			{
+				for (int x = rect.x0 + 1; x < rect.x1; x++)
+				{
+					points.push_back (idx (x, y));
 				}
 			}
+			return 0;
+		}
 
-			if (report_progress == FracProgress::Cout && i % _image_count == 0) {
+		// split the longer side, the dividing line becomes part of both borders
+		rect_t first = rect;
+		rect_t second = rect;
+		if (inner_width >= inner_height) {
+			int x = (rect.x0 + rect.x1) / 2;
+			for (int y = rect.y0 + 1; y < rect.y1; y++)
+			{
+				points.push_back (idx (x, y));
+			}
+			first.x1 = x;
+			second.x0 = x;
+		}
+		else {
+			int y = (rect.y0 + rect.y1) / 2;
+			for (int x = rect.x0 + 1; x < rect.x1; x++)
+			{
+				points.push_back (idx (x, y));
+			}
+			first.y1 = y;
+			second.y0 = y;
+		}
+		divided.push_back (first);
+		divided.push_back (second);
+		return 0;
+	}
+
+	bool border_has_color (rect_t rect, const std::vector<pixel_t>& frame, pixel_t color) const {
+		for (int x = rect.x0; x <= rect.x1; x++)
+		{
+			if (frame[idx (x, rect.y0)] != color || frame[idx (x, rect.y1)] != color)
+				return false;
+		}
+		for (int y = rect.y0 + 1; y < rect.y1; y++)
+		{
+			if (frame[idx (rect.x0, y)] != color || frame[idx (rect.x1, y)] != color)
+				return false;
+		}
+		return true;
+	}
+};
+
+/**
+Temporal reprojection: every frame is rendered as iteration counts at
+supersampling times the resolution in both directions and averaged down to the
+image. A frame is zoom times the size of the one before, so the point of every
+sample lies between 2x2 samples of the frame before. If these have the same
+count the sample takes it, only the others are iterated: the edges of the set,
+the border a frame exposes when it moves (only the first frames do) and the
+rows due for a refresh. Whole rows and runs of samples at least as long as a
+step of the row kernel go to the row kernel, the scattered samples in between
+to the point kernel.
+
+A detail which grows out of a uniform area, like a filament thinner than a
+sample, only shows up once its samples are iterated again, which they are every
+refresh_period frames: every frame iterates one in refresh_period rows of
+samples completely (0 never refreshes). Frames which raise the iteration budget
+are iterated completely.
+*/
+template<
+	FracUseCPUExt cpu_ext = FracUseCPUExt::Auto,
+	int pixels_size = 1,
+	FracProgress report_progress = FracProgress::Cout,
+	typename parallelizer = pool_group
+>
+class FracCPU_TR : public FracCPU<cpu_ext, pixels_size, report_progress> {
+	using Base = FracCPU<cpu_ext, pixels_size, report_progress>;
+	using Base::_image_width;
+	using Base::_image_height;
+	using Base::_timer;
+	using Base::_cpu_ext;
+	using Base::_fill_count_row;
+	using Base::_fill_count_points;
+	using Base::_skipped_pixels;
+	using Base::_series_iterations;
+	using Base::start_encoders;
+	using Base::_sinks;
+	using Base::reject_store;
+	using Base::average_taps;
+	size_t _task_count;
+	int _supersampling;
+	size_t _refresh_period;
+	/** Frame buffers shared by the renderer and the encoders, one encoder less than buffers */
+	size_t _frames_in_flight;
+	int _sample_width;
+	int _sample_height;
+	/** The supersampling x supersampling samples of every pixel */
+	taps_t _columns;
+	taps_t _rows;
+
+	/** Rows of the image a task renders at once, the tasks take turns */
+	static constexpr int band_height = 4;
+
+public:
+	FracCPU_TR (int image_width, int image_height, size_t task_count, int supersampling = 2, size_t refresh_period = 16, size_t frames_in_flight = 3)
+		: Base (image_width, image_height, "FracCPU_TR using " + std::string (typeid(parallelizer).name ()) + " (" + std::to_string (task_count) + ", " + std::to_string (supersampling) + "x" + std::to_string (supersampling) + " samples, refresh every " + std::to_string (refresh_period) + ")"), _task_count{ task_count },
+		_supersampling{ supersampling }, _refresh_period{ refresh_period }, _frames_in_flight{ std::max<size_t> (frames_in_flight, 1) },
+		_sample_width{ image_width * supersampling }, _sample_height{ image_height * supersampling } {
+		if (supersampling < 1)
+			throw std::invalid_argument ("supersampling must be at least 1 (is " + std::to_string (supersampling) + ")");
+		_columns = box_taps (image_width, supersampling);
+		_rows = box_taps (image_height, supersampling);
+	}
+
+	void execute (const FractalZooming& zooming) {
+		// the samples are counts, the frames their average color
+		if (zooming.frame_format != FractalZooming::FrameFormat::RGBA)
+			throw std::invalid_argument ("FracCPU_TR only renders RGBA frames");
+		reject_store ();
+		if (zooming.colors ().size () > (size_t)std::numeric_limits<iteration_count_t>::max () + 1)
+			throw std::invalid_argument ("iteration counts address at most 65536 colors (there are " + std::to_string (zooming.colors ().size ()) + ")");
+
+		AnimatedGif image("zoom.gif", _image_width, _image_height);
+		auto delay = 33ms;
+		FrameRing frames{ _frames_in_flight, (size_t)_image_width * _image_height };
+		std::vector<iteration_count_t> samples((size_t)_sample_width * _sample_height);
+		std::vector<iteration_count_t> previous(samples.size ());
+		std::vector<int> previous_x(_sample_width);
+		std::vector<int> previous_y(_sample_height);
+		complex_d_t previous_lower_left{};
+		std::array<double, 2> previous_scale{};
+		std::vector<size_t> skipped(_task_count);
+		_skipped_pixels.assign (zooming.zoom_steps, 0);
+		_series_iterations.assign (zooming.zoom_steps, 0);
+
+		_timer.start ("all");
+
+		const bool save_gif = zooming.save_images == FractalZooming::SaveImage::ToDisk;
+		const bool save = save_gif || !_sinks.empty ();
+		EncoderThreads encoders{ frames };
+		if (save)
+			start_encoders (encoders, save_gif ? &image : nullptr, zooming, delay, std::max<size_t> (_frames_in_flight - 1, 1));
+
+		for (size_t i = 0; i < zooming.zoom_steps; i++)
+		{
+			parallelizer group;
+			std::vector<pixel_t>& frame = frames.acquire ();
+			complex_d_t lower_left, upper_right;
+			std::tie (lower_left, upper_right) = zooming.frame_bounds (i);
+			auto scale = compute_scale (lower_left, upper_right, _sample_width, _sample_height);
+			auto iterations = zooming.frame_iterations (i);
+			auto series = zooming.frame_series (lower_left, upper_right, scale, iterations);
+			_series_iterations[i] = series.skipped;
+
+			// bounded samples get another count with another budget
+			bool reproject = i > 0 && iterations == zooming.frame_iterations (i - 1);
+			if (reproject)
+				map_samples (lower_left, scale, previous_lower_left, previous_scale, previous_x, previous_y);
+
+			for (size_t p = 0; p < _task_count; p++)
+			{
+				group.add ([this, i, reproject, &frame, &samples, &previous, &previous_x, &previous_y, &frame_skipped = skipped[p], &lower_left, &scale, iterations, &series, &zooming](size_t first) {
+					frame_skipped = fill_bands (first, i, reproject ? &previous : nullptr, previous_x, previous_y, samples, frame, zooming, lower_left, scale, iterations, series);
+					}, p);
+			}
+
+			group.join_all ();
+			// in pixels, so it compares with the other renderers
+			size_t samples_per_pixel = (size_t)_supersampling * _supersampling;
+			_skipped_pixels[i] = std::accumulate (std::begin (skipped), std::end (skipped), size_t{ 0 }) / samples_per_pixel;
+
+			std::swap (samples, previous);
+			previous_lower_left = lower_left;
+			previous_scale = scale;
+
+			if (save)
+				frames.publish ();
+
+			if (report_progress == FracProgress::Cout && i % 10 == 0) {
 				std::cout << i << " ";
 			}
 		}
 		if (report_progress == FracProgress::Cout) std::cout << std::endl;
 
+		encoders.join ();
+
 		_timer.stop ();
 	}
+
+private:
+	/**
+	Column of the previous samples left of the point of every column of samples
+	and row of the previous samples above the point of every row, -1 where the
+	2x2 samples from there leave the previous frame. The rows count from the top
+	like the rows of the kernels.
+	*/
+	void map_samples (const complex_d_t& lower_left, const std::array<double, 2>& scale, const complex_d_t& previous_lower_left, const std::array<double, 2>& previous_scale, std::vector<int>& previous_x, std::vector<int>& previous_y) const {
+		for (int x = 0; x < _sample_width; x++)
+		{
+			double real = lower_left.real () + x * scale[0];
+			previous_x[x] = cell ((real - previous_lower_left.real ()) / previous_scale[0], _sample_width);
+		}
+		for (int y = 0; y < _sample_height; y++)
+		{
+			double imag = lower_left.imag () + (_sample_height - y - 1) * scale[1];
+			previous_y[y] = cell (_sample_height - 1 - (imag - previous_lower_left.imag ()) / previous_scale[1], _sample_height);
+		}
+	}
+
+	static taps_t box_taps (int pixels, int supersampling) {
+		taps_t taps{ supersampling, std::vector<int> ((size_t)pixels * supersampling) };
+		std::iota (std::begin (taps.samples), std::end (taps.samples), 0);
+		return taps;
+	}
+
+	static int cell (double position, int size) {
+		double first = std::floor (position);
+		return first >= 0 && first + 1 < size ? (int)first : -1;
+	}
+
+	/** The rows take turns, so the refreshed samples are contiguous for the row kernel */
+	bool due_for_refresh (int y, size_t frame) const {
+		return _refresh_period != 0 && (size_t)y % _refresh_period == frame % _refresh_period;
+	}
+
+	/**
+	Takes the count of the previous samples around the point of every sample of
+	row y and marks the samples to iterate, where these differ or leave the
+	previous frame. Returns the samples which were taken.
+	*/
+	size_t reproject_row (int y, const std::vector<iteration_count_t>& previous, const std::vector<int>& previous_x, int previous_row, std::vector<iteration_count_t>& samples, std::vector<unsigned char>& iterate) const {
+		const iteration_count_t* above = previous.data () + (size_t)previous_row * _sample_width;
+		const iteration_count_t* below = above + _sample_width;
+		iteration_count_t* row = samples.data () + (size_t)y * _sample_width;
+		size_t taken = 0;
+		// without branches, they would mispredict on the scattered samples to iterate
+		for (int x = 0; x < _sample_width; x++)
+		{
+			int column = std::max (previous_x[x], 0);
+			iteration_count_t count = above[column];
+			row[x] = count;
+			iterate[x] = previous_x[x] < 0 || above[column + 1] != count || below[column] != count || below[column + 1] != count;
+			taken += !iterate[x];
+		}
+		return taken;
+	}
+
+	/**
+	Renders every task_count-th band of rows starting at first, the samples are
+	taken from previous where they agree, unless it is nullptr. Returns the
+	samples which were not iterated.
+	*/
+	size_t fill_bands (size_t first, size_t frame_index, const std::vector<iteration_count_t>* previous, const std::vector<int>& previous_x, const std::vector<int>& previous_y, std::vector<iteration_count_t>& samples, std::vector<pixel_t>& frame, const FractalZooming& zooming, const complex_d_t& lower_left, const std::array<double, 2>& scale, size_t iterations, const series_t& series) const {
+		const int sample_band_height = band_height * _supersampling;
+		// shorter runs leave lanes of the row kernel idle, the point kernel fills them
+		const int min_span = vector_lanes (_cpu_ext) * pixels_size;
+		std::vector<size_t> points;
+		std::vector<unsigned char> iterate(_sample_width);
+		size_t skipped = 0;
+		for (int y_begin = (int)first * sample_band_height; y_begin < _sample_height; y_begin += (int)_task_count * sample_band_height)
+		{
+			int y_end = std::min (y_begin + sample_band_height, _sample_height);
+			if (!previous) {
+				skipped += _fill_count_row (y_begin, y_end, 0, _sample_width, samples.data (), zooming, lower_left, scale, iterations, series, _sample_width, _sample_height);
+			}
+			else {
+				points.clear ();
+				for (int y = y_begin; y < y_end; y++)
+				{
+					if (previous_y[y] < 0 || due_for_refresh (y, frame_index)) {
+						skipped += _fill_count_row (y, y + 1, 0, _sample_width, samples.data (), zooming, lower_left, scale, iterations, series, _sample_width, _sample_height);
+						continue;
+					}
+					skipped += reproject_row (y, *previous, previous_x, previous_y[y], samples, iterate);
+					for (int x = 0; x < _sample_width;)
+					{
+						if (!iterate[x]) {
+							x++;
+							continue;
+						}
+						int x_begin = x;
+						while (x < _sample_width && iterate[x])
+							x++;
+						if (x - x_begin >= min_span) {
+							skipped += _fill_count_row (y, y + 1, x_begin, x, samples.data (), zooming, lower_left, scale, iterations, series, _sample_width, _sample_height);
+						}
+						else {
+							for (int p = x_begin; p < x; p++)
+								points.push_back ((size_t)y * _sample_width + p);
+						}
+					}
+				}
+				skipped += _fill_count_points (points, samples, zooming, lower_left, scale, iterations, series, _sample_width, _sample_height);
+			}
+			average_taps (y_begin / _supersampling, y_end / _supersampling, samples, _sample_width, _columns, _rows, zooming.colors (), frame);
+		}
+		return skipped;
+	}
+};
+
+/**
+Keyframes: instead of every frame only a keyframe every keyframe_zoom times of
+zoom is rendered, as iteration counts at supersampling times the resolution in
+both directions. The frames up to the next keyframe are cropped from it, the
+pixels of frame i after keyframe k span zoom^(i - k) times supersampling
+samples, which every pixel averages. The deepest frame of a keyframe gets
+supersampling / keyframe_zoom samples per pixel across, the frames get
+blurrier towards it once that drops below 1.
+
+A keyframe is rendered with the budget of the deepest of its frames. A frame
+which leaves the keyframe (like the first one unless it is centered on the
+zoom center) gets a keyframe of its own. keyframe_zoom 1 renders a keyframe per
+frame, which equals iterating every sample.
+*/
+template<
+	FracUseCPUExt cpu_ext = FracUseCPUExt::Auto,
+	int pixels_size = 1,
+	FracProgress report_progress = FracProgress::Cout,
+	typename parallelizer = pool_group
+>
+class FracCPU_KF : public FracCPU<cpu_ext, pixels_size, report_progress> {
+	using Base = FracCPU<cpu_ext, pixels_size, report_progress>;
+	using Base::_image_width;
+	using Base::_image_height;
+	using Base::_timer;
+	using Base::_fill_count_row;
+	using Base::_skipped_pixels;
+	using Base::_series_iterations;
+	using Base::start_encoders;
+	using Base::_sinks;
+	using Base::reject_store;
+	using Base::average_taps;
+	size_t _task_count;
+	int _supersampling;
+	double _keyframe_zoom;
+	/** Frame buffers shared by the renderer and the encoders, one encoder less than buffers */
+	size_t _frames_in_flight;
+	int _sample_width;
+	int _sample_height;
+	/** Of the last execution */
+	size_t _keyframes = 0;
+	size_t _iterated_samples = 0;
+
+	/** Rows a task renders at once, the tasks take turns */
+	static constexpr int band_height = 4;
+
+public:
+	FracCPU_KF (int image_width, int image_height, size_t task_count, int supersampling = 2, double keyframe_zoom = 2, size_t frames_in_flight = 3)
+		: Base (image_width, image_height, "FracCPU_KF using " + std::string (typeid(parallelizer).name ()) + " (" + std::to_string (task_count) + ", " + std::to_string (supersampling) + "x" + std::to_string (supersampling) + " samples, keyframe every " + format_zoom (keyframe_zoom) + "x)"), _task_count{ task_count },
+		_supersampling{ supersampling }, _keyframe_zoom{ keyframe_zoom }, _frames_in_flight{ std::max<size_t> (frames_in_flight, 1) },
+		_sample_width{ image_width * supersampling }, _sample_height{ image_height * supersampling } {
+		if (supersampling < 1)
+			throw std::invalid_argument ("supersampling must be at least 1 (is " + std::to_string (supersampling) + ")");
+		if (!(keyframe_zoom >= 1))
+			throw std::invalid_argument ("keyframe_zoom must be at least 1 (is " + std::to_string (keyframe_zoom) + ")");
+	}
+
+	void execute (const FractalZooming& zooming) {
+		// the samples are counts, the frames their average color
+		if (zooming.frame_format != FractalZooming::FrameFormat::RGBA)
+			throw std::invalid_argument ("FracCPU_KF only renders RGBA frames");
+		reject_store ();
+		if (zooming.colors ().size () > (size_t)std::numeric_limits<iteration_count_t>::max () + 1)
+			throw std::invalid_argument ("iteration counts address at most 65536 colors (there are " + std::to_string (zooming.colors ().size ()) + ")");
+
+		AnimatedGif image("zoom.gif", _image_width, _image_height);
+		auto delay = 33ms;
+		FrameRing frames{ _frames_in_flight, (size_t)_image_width * _image_height };
+		std::vector<iteration_count_t> samples((size_t)_sample_width * _sample_height);
+		taps_t columns, rows;
+		std::vector<size_t> skipped(_task_count);
+		_skipped_pixels.assign (zooming.zoom_steps, 0);
+		_series_iterations.assign (zooming.zoom_steps, 0);
+		_keyframes = 0;
+		_iterated_samples = 0;
+
+		_timer.start ("all");
+
+		const bool save_gif = zooming.save_images == FractalZooming::SaveImage::ToDisk;
+		const bool save = save_gif || !_sinks.empty ();
+		EncoderThreads encoders{ frames };
+		if (save)
+			start_encoders (encoders, save_gif ? &image : nullptr, zooming, delay, std::max<size_t> (_frames_in_flight - 1, 1));
+
+		size_t i = 0;
+		while (i < zooming.zoom_steps)
+		{
+			complex_d_t key_lower_left, key_upper_right;
+			std::tie (key_lower_left, key_upper_right) = zooming.frame_bounds (i);
+			size_t last = i;
+			while (last + 1 < zooming.zoom_steps && in_keyframe (zooming, key_lower_left, key_upper_right, last + 1))
+			{
+				last++;
+			}
+
+			auto key_scale = compute_scale (key_lower_left, key_upper_right, _sample_width, _sample_height);
+			auto iterations = zooming.frame_iterations (last);
+			auto series = zooming.frame_series (key_lower_left, key_upper_right, key_scale, iterations);
+			{
+				parallelizer group;
+				for (size_t p = 0; p < _task_count; p++)
+				{
+					group.add ([this, &samples, &frame_skipped = skipped[p], &zooming, &key_lower_left, &key_scale, iterations, &series](size_t first) {
+						frame_skipped = fill_keyframe_bands (first, samples, zooming, key_lower_left, key_scale, iterations, series);
+						}, p);
+				}
+				group.join_all ();
+			}
+			size_t keyframe_skipped = std::accumulate (std::begin (skipped), std::end (skipped), size_t{ 0 });
+			_keyframes++;
+			_iterated_samples += samples.size () - keyframe_skipped;
+			const size_t key = i;
+
+			for (; i <= last; i++)
+			{
+				std::vector<pixel_t>& frame = frames.acquire ();
+				complex_d_t lower_left, upper_right;
+				std::tie (lower_left, upper_right) = zooming.frame_bounds (i);
+				auto scale = compute_scale (lower_left, upper_right, _image_width, _image_height);
+				map_taps (lower_left.real (), scale[0], key_lower_left.real (), key_scale[0], _image_width, _sample_width, false, columns);
+				map_taps (lower_left.imag (), scale[1], key_lower_left.imag (), key_scale[1], _image_height, _sample_height, true, rows);
+				_series_iterations[i] = i == key ? series.skipped : 0;
+				// in pixels, so it compares with the other renderers, the other frames are not iterated at all
+				_skipped_pixels[i] = i == key
+					? keyframe_skipped / ((size_t)_supersampling * _supersampling)
+					: (size_t)_image_width * _image_height;
+
+				parallelizer group;
+				for (size_t p = 0; p < _task_count; p++)
+				{
+					group.add ([this, &frame, &samples, &columns, &rows, &zooming](size_t first) {
+						crop_bands (first, samples, columns, rows, frame, zooming.colors ());
+						}, p);
+				}
+				group.join_all ();
+
+				if (save)
+					frames.publish ();
+
+				if (report_progress == FracProgress::Cout && i % 10 == 0) {
+					std::cout << i << " ";
+				}
+			}
+		}
+		if (report_progress == FracProgress::Cout) {
+			std::cout << std::endl;
+			std::cout << _keyframes << " keyframes for " << zooming.zoom_steps << " frames, "
+				<< std::setprecision (2) << std::fixed
+				<< (double)_iterated_samples / zooming.zoom_steps / ((size_t)_image_width * _image_height)
+				<< " samples iterated per pixel" << std::endl;
+		}
+
+		encoders.join ();
+
+		_timer.stop ();
+	}
+
+	/** Keyframes rendered by the last execution */
+	size_t keyframes () const {
+		return _keyframes;
+	}
+
+	/** Samples of all keyframes of the last execution which were iterated (not skipped) */
+	size_t iterated_samples () const {
+		return _iterated_samples;
+	}
+
+private:
+	static std::string format_zoom (double zoom) {
+		std::ostringstream text;
+		text << zoom;
+		return text.str ();
+	}
+
+	/** Whether the given frame lies in the keyframe and spans at least 1 / keyframe_zoom of it */
+	bool in_keyframe (const FractalZooming& zooming, const complex_d_t& key_lower_left, const complex_d_t& key_upper_right, size_t frame) const {
+		complex_d_t lower_left, upper_right;
+		std::tie (lower_left, upper_right) = zooming.frame_bounds (frame);
+		// tolerates the rounding of the bounds, keyframe_zoom 1 takes only equal frames
+		double tolerance = 1e-9 * (key_upper_right.real () - key_lower_left.real ());
+		double ratio = (upper_right.real () - lower_left.real ()) / (key_upper_right.real () - key_lower_left.real ());
+		return ratio * _keyframe_zoom >= 1 - 1e-9
+			&& lower_left.real () >= key_lower_left.real () - tolerance && upper_right.real () <= key_upper_right.real () + tolerance
+			&& lower_left.imag () >= key_lower_left.imag () - tolerance && upper_right.imag () <= key_upper_right.imag () + tolerance;
+	}
+
+	/**
+	Nearest samples of the keyframe to taps.count points evenly spread over every
+	pixel along one axis, as many as the samples a pixel spans (at least 1).
+	Flipped counts the samples from the top like the rows of the kernels.
+	*/
+	static void map_taps (double lower, double scale, double key_lower, double key_scale, int pixels, int key_samples, bool flipped, taps_t& taps) {
+		double footprint = scale / key_scale;
+		taps.count = std::max (1, (int)std::lround (footprint));
+		taps.samples.resize ((size_t)pixels * taps.count);
+		for (int p = 0; p < pixels; p++)
+		{
+			// the kernels put row p at lower + (pixels - p - 1) * scale
+			double center = flipped ? pixels - p - 1 : p;
+			for (int t = 0; t < taps.count; t++)
+			{
+				double offset = (t + 0.5) / taps.count - 0.5;
+				double position = (lower + (center + offset) * scale - key_lower) / key_scale;
+				int sample = (int)std::lround (flipped ? key_samples - 1 - position : position);
+				taps.samples[(size_t)p * taps.count + t] = std::clamp (sample, 0, key_samples - 1);
+			}
+		}
+	}
+
+	/** Renders every task_count-th band of rows of the keyframe starting at first, returns the samples which were not iterated */
+	size_t fill_keyframe_bands (size_t first, std::vector<iteration_count_t>& samples, const FractalZooming& zooming, const complex_d_t& lower_left, const std::array<double, 2>& scale, size_t iterations, const series_t& series) const {
+		const int sample_band_height = band_height * _supersampling;
+		size_t skipped = 0;
+		for (int y_begin = (int)first * sample_band_height; y_begin < _sample_height; y_begin += (int)_task_count * sample_band_height)
+		{
+			int y_end = std::min (y_begin + sample_band_height, _sample_height);
+			skipped += _fill_count_row (y_begin, y_end, 0, _sample_width, samples.data (), zooming, lower_left, scale, iterations, series, _sample_width, _sample_height);
+		}
+		return skipped;
+	}
+
+	/** Every pixel of every task_count-th band of rows starting at first gets the average color of its taps */
+	void crop_bands (size_t first, const std::vector<iteration_count_t>& samples, const taps_t& columns, const taps_t& rows, std::vector<pixel_t>& frame, const std::vector<pixel_t>& colors) const {
+		for (int y_begin = (int)first * band_height; y_begin < _image_height; y_begin += (int)_task_count * band_height)
+		{
+			average_taps (y_begin, std::min (y_begin + band_height, _image_height), samples, _sample_width, columns, rows, colors, frame);
+		}
+	}
 };
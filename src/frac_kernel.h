@@ -0,0 +1,169 @@
+#pragma once
+
+#include <vector>
+#include <array>
+#include <tuple>
+#include <string>
+#include <algorithm>
+#include <stdexcept>
+#include <type_traits>
+#include <bitset>
+#include <cmath>
+#include <cstdint>
+
+#include "frac.h"
+
+#include "immintrin.h"
+
+enum class FracUseCPUExt {
+	/** Select the best extension supported by the host at runtime */
+	Auto,
+	None,
+	AVX,
+	/** AVX2 + FMA */
+	AVX_FMA,
+	/** AVX-512F (implies AVX2 + FMA) */
+	AVX512
+};
+
+constexpr bool uses_avx (FracUseCPUExt cpu_ext) {
+	return cpu_ext == FracUseCPUExt::AVX || cpu_ext == FracUseCPUExt::AVX_FMA || cpu_ext == FracUseCPUExt::AVX512;
+}
+
+constexpr bool uses_fma (FracUseCPUExt cpu_ext) {
+	return cpu_ext == FracUseCPUExt::AVX_FMA || cpu_ext == FracUseCPUExt::AVX512;
+}
+
+/** Number of pixels computed per vector */
+constexpr int vector_lanes (FracUseCPUExt cpu_ext) {
+	return cpu_ext == FracUseCPUExt::AVX512 ? 16 : 8;
+}
+
+inline std::string cpu_ext_name (FracUseCPUExt cpu_ext) {
+	switch (cpu_ext)
+	{
+		case FracUseCPUExt::Auto:
+			return "Auto";
+		case FracUseCPUExt::AVX:
+			return "AVX";
+		case FracUseCPUExt::AVX_FMA:
+			return "AVX2+FMA";
+		case FracUseCPUExt::AVX512:
+			return "AVX512";
+		default:
+			return "None";
+	}
+}
+
+#define FRAC_PRAGMA(text) _Pragma (#text)
+
+/**
+Functions defined between FRAC_KERNEL_TARGET_BEGIN ("avx2,fma") and
+FRAC_KERNEL_TARGET_END are compiled for the given extensions, the rest of the
+translation unit for the baseline, see frac_kernel_impl.h. MSVC compiles the
+intrinsics of every extension without /arch, so it needs no region.
+*/
+#if defined(__clang__)
+#define FRAC_KERNEL_TARGET_BEGIN(extensions) FRAC_PRAGMA (clang attribute push (__attribute__ ((target (extensions))), apply_to = function))
+#define FRAC_KERNEL_TARGET_END FRAC_PRAGMA (clang attribute pop)
+#elif defined(__GNUC__)
+#define FRAC_KERNEL_TARGET_BEGIN(extensions) FRAC_PRAGMA (GCC push_options) FRAC_PRAGMA (GCC target (extensions))
+#define FRAC_KERNEL_TARGET_END FRAC_PRAGMA (GCC pop_options)
+#else
+#define FRAC_KERNEL_TARGET_BEGIN(extensions)
+#define FRAC_KERNEL_TARGET_END
+#endif
+
+/**
+Fills the pixels [x_begin, x_end) of the rows [y_begin, y_end) of the image, see FracKernel::fill_row.
+The image is a pointer, so the frames may live in any buffer, e.g. a FrameStore.
+lower_left is relative to FractalZooming::zoom_center (see FractalZooming::frame_bounds)
+and iterated in FractalZooming::frame_precision, series from FractalZooming::frame_series.
+Returns the number of pixels which were skipped as they are known to be bounded.
+*/
+template<typename pixel_type>
+using fill_rows_fn = size_t (*)(size_t y_begin, size_t y_end, int x_begin, int x_end, pixel_type* image, const FractalZooming& zooming, const complex_d_t& lower_left, const std::array<double, 2>& scale, size_t iterations, const series_t& series, int image_width, int image_height);
+
+using fill_row_fn = fill_rows_fn<pixel_t>;
+/** Writes the palette index of every pixel instead of its color, see FractalZooming::palette_index */
+using fill_index_row_fn = fill_rows_fn<palette_index_t>;
+
+/**
+Returns the row kernel compiled for the given extension.
+Each specialization lives in its own translation unit (frac_kernel_*.cpp) whose
+kernels are compiled for the matching instruction set. Only call it for an
+extension supported by the host.
+*/
+template<FracUseCPUExt cpu_ext>
+fill_row_fn frac_fill_row (int pixels_size);
+
+template<> fill_row_fn frac_fill_row<FracUseCPUExt::None> (int pixels_size);
+template<> fill_row_fn frac_fill_row<FracUseCPUExt::AVX> (int pixels_size);
+template<> fill_row_fn frac_fill_row<FracUseCPUExt::AVX_FMA> (int pixels_size);
+template<> fill_row_fn frac_fill_row<FracUseCPUExt::AVX512> (int pixels_size);
+
+/** Returns the row kernel writing palette indices, see frac_fill_row */
+template<FracUseCPUExt cpu_ext>
+fill_index_row_fn frac_fill_index_row (int pixels_size);
+
+template<> fill_index_row_fn frac_fill_index_row<FracUseCPUExt::None> (int pixels_size);
+template<> fill_index_row_fn frac_fill_index_row<FracUseCPUExt::AVX> (int pixels_size);
+template<> fill_index_row_fn frac_fill_index_row<FracUseCPUExt::AVX_FMA> (int pixels_size);
+template<> fill_index_row_fn frac_fill_index_row<FracUseCPUExt::AVX512> (int pixels_size);
+
+/** Writes the entry of FractalZooming::colors of every pixel, see FractalZooming::FrameFormat::IterationCounts */
+using fill_count_row_fn = fill_rows_fn<iteration_count_t>;
+
+/** Returns the row kernel writing iteration counts, see frac_fill_row */
+template<FracUseCPUExt cpu_ext>
+fill_count_row_fn frac_fill_count_row (int pixels_size);
+
+template<> fill_count_row_fn frac_fill_count_row<FracUseCPUExt::None> (int pixels_size);
+template<> fill_count_row_fn frac_fill_count_row<FracUseCPUExt::AVX> (int pixels_size);
+template<> fill_count_row_fn frac_fill_count_row<FracUseCPUExt::AVX_FMA> (int pixels_size);
+template<> fill_count_row_fn frac_fill_count_row<FracUseCPUExt::AVX512> (int pixels_size);
+
+/**
+Colors pixel_count iteration counts with the color map, which needs an entry
+for every count in the frame. Any color map of the size the frame was rendered
+with can be used, so changing the colors needs no rendering.
+*/
+using color_frame_fn = void (*)(const iteration_count_t* counts, size_t pixel_count, const pixel_t* color_map, pixel_t* image);
+
+/** Returns the coloring pass compiled for the given extension, see frac_fill_row */
+template<FracUseCPUExt cpu_ext>
+color_frame_fn frac_color_frame ();
+
+template<> color_frame_fn frac_color_frame<FracUseCPUExt::None> ();
+template<> color_frame_fn frac_color_frame<FracUseCPUExt::AVX> ();
+template<> color_frame_fn frac_color_frame<FracUseCPUExt::AVX_FMA> ();
+template<> color_frame_fn frac_color_frame<FracUseCPUExt::AVX512> ();
+
+/**
+Fills the pixels at the given image indices, see FracKernel::fill_points.
+Returns the number of pixels which were skipped as they are known to be bounded.
+*/
+template<typename pixel_type>
+using fill_point_list_fn = size_t (*)(const std::vector<size_t>& points, std::vector<pixel_type>& image, const FractalZooming& zooming, const complex_d_t& lower_left, const std::array<double, 2>& scale, size_t iterations, const series_t& series, int image_width, int image_height);
+
+using fill_points_fn = fill_point_list_fn<pixel_t>;
+/** Writes iteration counts, see fill_count_row_fn */
+using fill_count_points_fn = fill_point_list_fn<iteration_count_t>;
+
+/** Returns the point kernel compiled for the given extension, see frac_fill_row */
+template<FracUseCPUExt cpu_ext>
+fill_points_fn frac_fill_points (int pixels_size);
+
+template<> fill_points_fn frac_fill_points<FracUseCPUExt::None> (int pixels_size);
+template<> fill_points_fn frac_fill_points<FracUseCPUExt::AVX> (int pixels_size);
+template<> fill_points_fn frac_fill_points<FracUseCPUExt::AVX_FMA> (int pixels_size);
+template<> fill_points_fn frac_fill_points<FracUseCPUExt::AVX512> (int pixels_size);
+
+/** Returns the point kernel writing iteration counts, see frac_fill_row */
+template<FracUseCPUExt cpu_ext>
+fill_count_points_fn frac_fill_count_points (int pixels_size);
+
+template<> fill_count_points_fn frac_fill_count_points<FracUseCPUExt::None> (int pixels_size);
+template<> fill_count_points_fn frac_fill_count_points<FracUseCPUExt::AVX> (int pixels_size);
+template<> fill_count_points_fn frac_fill_count_points<FracUseCPUExt::AVX_FMA> (int pixels_size);
+template<> fill_count_points_fn frac_fill_count_points<FracUseCPUExt::AVX512> (int pixels_size);
@@ -0,0 +1,35 @@
+#include "frac_kernel.h"
+
+FRAC_KERNEL_TARGET_BEGIN ("avx512f,avx2,fma")
+#include "frac_kernel_impl.h"
+FRAC_KERNEL_TARGET_END
+
+template<>
+fill_row_fn frac_fill_row<FracUseCPUExt::AVX512> (int pixels_size) {
+	return select_fill_row<FracUseCPUExt::AVX512> (pixels_size);
+}
+
+template<>
+fill_index_row_fn frac_fill_index_row<FracUseCPUExt::AVX512> (int pixels_size) {
+	return select_fill_row<FracUseCPUExt::AVX512, palette_index_t> (pixels_size);
+}
+
+template<>
+fill_count_row_fn frac_fill_count_row<FracUseCPUExt::AVX512> (int pixels_size) {
+	return select_fill_row<FracUseCPUExt::AVX512, iteration_count_t> (pixels_size);
+}
+
+template<>
+fill_points_fn frac_fill_points<FracUseCPUExt::AVX512> (int pixels_size) {
+	return select_fill_points<FracUseCPUExt::AVX512> (pixels_size);
+}
+
+template<>
+fill_count_points_fn frac_fill_count_points<FracUseCPUExt::AVX512> (int pixels_size) {
+	return select_fill_points<FracUseCPUExt::AVX512, iteration_count_t> (pixels_size);
+}
+
+template<>
+color_frame_fn frac_color_frame<FracUseCPUExt::AVX512> () {
+	return &color_frame<FracUseCPUExt::AVX512>;
+}
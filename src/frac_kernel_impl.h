@@ -0,0 +1,1812 @@
+#pragma once
+
+#include "frac_kernel.h"
+
+/*
+The kernels, only included by the frac_kernel_*.cpp translation units. They
+include it in a region which compiles every function defined in it for their
+instruction set (see FRAC_KERNEL_TARGET_BEGIN), everything
+included before it, like the standard library and FractalZooming, is compiled
+for the baseline. On top of that the kernels get internal linkage, so the code
+generated for one instruction set can never be merged into the translation unit
+of another or replace the baseline code of a function shared with it.
+*/
+namespace {
+
+/**
+Computes the pixels of a single row.
+Can use AVX, FMA and AVX-512 extensions
+*/
+template<
+	FracUseCPUExt cpu_ext,
+	/** Defines how many pixels (multiplied by 8, or 16 with AVX-512) are filled in a row */
+	int pixels_size = 1,
+	/** Iteration budget known at compile time, 0 if it is only known at runtime */
+	size_t fixed_iterations = 0,
+	/** Color of the pixels (pixel_t), their palette index (palette_index_t) or entry of the color map (iteration_count_t) */
+	typename pixel_type = pixel_t
+>
+class FracKernel {
+	using Precision = FractalZooming::Precision;
+
+	int _image_width;
+	int _image_height;
+	size_t _iterations;
+	bool _check_interior;
+	bool _check_periodicity;
+	/** The kernels turn the counts into entries of the gradient, see smooth_entry */
+	bool _smooth;
+	/** Only the runtime budget has smooth kernels, see fill_row_iterations */
+	static constexpr bool smooth_kernels = fixed_iterations == 0;
+	/** Entries of the gradient per iteration and the entries escaped points cycle through */
+	float _gradient_step;
+	float _gradient_cycle;
+	/** FractalZooming::colors */
+	const pixel_t* _colors;
+	/** FractalZooming::zoom_center, which the bounds are relative to, and its orbit */
+	complex_d_t _center;
+	/** _center with the digits double-double keeps, for the double-double kernels */
+	complex_dd_t _exact_center;
+	const reference_orbit_t* _reference;
+	/** Perturbation starts the pixels at _series.skipped */
+	series_t _series;
+	size_t _skipped_pixels = 0;
+	/** End of the span filled by fill_row, the vectors crossing it are clipped */
+	int _row_end;
+
+public:
+	FracKernel (int image_width, int image_height, size_t iterations, const series_t& series, const FractalZooming& zooming)
+		: _image_width{ image_width }, _image_height{ image_height }, _iterations{ iterations },
+		_check_interior{ zooming.interior_check == FractalZooming::InteriorCheck::CardioidAndBulb },
+		_check_periodicity{ zooming.periodicity_check == FractalZooming::PeriodicityCheck::Brent },
+		_smooth{ zooming.coloring == FractalZooming::Coloring::Smooth },
+		_gradient_cycle{ (float)zooming.gradient.size () - 1 },
+		_colors{ zooming.colors ().data () }, _center{ zooming.zoom_center.to_double () }, _exact_center{ zooming.zoom_center },
+		_reference{ &zooming.reference_orbit }, _series{ series }, _row_end{ image_width } {
+		if (_smooth && zooming.gradient.size () < 2)
+			throw std::invalid_argument ("smooth coloring needs a gradient of at least 2 colors");
+		_gradient_step = _gradient_cycle / zooming.gradient_period;
+	}
+
+	static size_t fill_rows (size_t y_begin, size_t y_end, int x_begin, int x_end, pixel_type* image, const FractalZooming& zooming, const complex_d_t& lower_left, const std::array<double, 2>& scale, size_t iterations, const series_t& series, int image_width, int image_height) {
+		FracKernel kernel{ image_width, image_height, iterations, series, zooming };
+		// the fixed budgets are only specialized for float, see fill_row_iterations
+		if constexpr (fixed_iterations == 0) {
+			switch (zooming.frame_precision (scale))
+			{
+				case Precision::Perturbation:
+					for (size_t y = y_begin; y < y_end; y++)
+					{
+						kernel.fill_row_double<Precision::Perturbation> (y, x_begin, x_end, image, zooming, lower_left, scale);
+					}
+					return kernel._skipped_pixels;
+				case Precision::DoubleDouble:
+					for (size_t y = y_begin; y < y_end; y++)
+					{
+						kernel.fill_row_double<Precision::DoubleDouble> (y, x_begin, x_end, image, zooming, lower_left, scale);
+					}
+					return kernel._skipped_pixels;
+				case Precision::Double:
+					for (size_t y = y_begin; y < y_end; y++)
+					{
+						kernel.fill_row_double (y, x_begin, x_end, image, zooming, kernel._center + lower_left, scale);
+					}
+					return kernel._skipped_pixels;
+				default:
+					break;
+			}
+		}
+		auto lower_left_f = complex_t (kernel._center + lower_left);
+		auto scale_f = to_float (scale);
+		for (size_t y = y_begin; y < y_end; y++)
+		{
+			kernel.fill_row (y, x_begin, x_end, image, zooming, lower_left_f, scale_f);
+		}
+		return kernel._skipped_pixels;
+	}
+
+	static size_t fill_points (const std::vector<size_t>& points, pixel_type* image, const FractalZooming& zooming, const complex_d_t& lower_left, const std::array<double, 2>& scale, size_t iterations, const series_t& series, int image_width, int image_height) {
+		FracKernel kernel{ image_width, image_height, iterations, series, zooming };
+		if constexpr (fixed_iterations == 0) {
+			switch (zooming.frame_precision (scale))
+			{
+				case Precision::Perturbation:
+					kernel.fill_points_double<Precision::Perturbation> (points, image, zooming, lower_left, scale);
+					return kernel._skipped_pixels;
+				case Precision::DoubleDouble:
+					kernel.fill_points_double<Precision::DoubleDouble> (points, image, zooming, lower_left, scale);
+					return kernel._skipped_pixels;
+				case Precision::Double:
+					kernel.fill_points_double (points, image, zooming, kernel._center + lower_left, scale);
+					return kernel._skipped_pixels;
+				default:
+					break;
+			}
+		}
+		kernel.fill_points (points, image, zooming, complex_t (kernel._center + lower_left), to_float (scale));
+		return kernel._skipped_pixels;
+	}
+
+	static std::array<float, 2> to_float (const std::array<double, 2>& scale) {
+		return { (float)scale[0], (float)scale[1] };
+	}
+
+	/** Iteration budget, a constant when specialized for it */
+	inline
+	size_t iterations () const {
+		if constexpr (fixed_iterations != 0)
+			return fixed_iterations;
+		else
+			return _iterations;
+	}
+
+	inline
+	void fill_row (size_t y, int x_begin, int x_end, pixel_type* image, const FractalZooming& zooming, const complex_t& lower_left, const std::array<float, 2>& scale) {
+		_row_end = x_end;
+		if constexpr (cpu_ext == FracUseCPUExt::AVX512) {
+			for (size_t x = x_begin; x < _row_end; x += 16 * pixels_size)
+			{
+				fill_pixels_avx512<pixels_size> (x, y, image, zooming, lower_left, scale);
+			}
+		}
+		else if constexpr (uses_avx (cpu_ext)) {
+			for (size_t x = x_begin; x < _row_end; x += 8 * pixels_size)
+			{
+				if constexpr (pixels_size == 1)
+					fill_8_pixels (x, y, image, zooming, lower_left, scale);
+				else
+					fill_pixels<pixels_size> (x, y, image, zooming, lower_left, scale);
+			}
+		}
+		else {
+			for (size_t x = x_begin; x < _row_end; x++)
+			{
+				auto idx = y * _image_width + x;
+				image[idx] = get_color (iterate_point (idx_to_complex (x, y, lower_left, scale)), zooming);
+			}
+		}
+	}
+
+	/** Precisions whose bounds are offsets from _center instead of points */
+	static constexpr bool uses_offsets (Precision precision) {
+		return precision == Precision::Perturbation || precision == Precision::DoubleDouble;
+	}
+
+	/**
+	Row in double precision, 4 pixels per vector with every AVX extension
+	(AVX-512 included), so it takes twice the vectors of a float row.
+	With perturbation and double-double lower_left is relative to _center.
+	Perturbation gathers the reference orbit and double-double needs FMA for
+	its products, so AVX without AVX2 goes pixel by pixel for them.
+	*/
+	template<Precision precision = Precision::Double>
+	inline
+	void fill_row_double (size_t y, int x_begin, int x_end, pixel_type* image, const FractalZooming& zooming, const complex_d_t& lower_left, const std::array<double, 2>& scale) {
+		_row_end = x_end;
+		if constexpr (uses_avx (cpu_ext) && (!uses_offsets (precision) || uses_fma (cpu_ext))) {
+			for (size_t x = x_begin; x < _row_end; x += 4 * pixels_size)
+			{
+				fill_pixels_double<pixels_size, precision> (x, y, image, zooming, lower_left, scale);
+			}
+		}
+		else {
+			for (size_t x = x_begin; x < _row_end; x++)
+			{
+				auto idx = y * _image_width + x;
+				image[idx] = get_color (iterate_point<precision> (idx_to_complex (x, y, lower_left, scale)), zooming);
+			}
+		}
+	}
+
+	/**
+	Computes the pixels at arbitrary image indices, pixels_size vectors at a
+	time. Lanes past the last point are marked bounded, so they never iterate.
+	*/
+	inline
+	void fill_points (const std::vector<size_t>& points, pixel_type* image, const FractalZooming& zooming, const complex_t& lower_left, const std::array<float, 2>& scale) {
+		if constexpr (uses_avx (cpu_ext)) {
+			constexpr size_t lanes = vector_lanes (cpu_ext);
+			constexpr size_t batch = lanes * pixels_size;
+			for (size_t p = 0; p < points.size (); p += batch)
+			{
+				auto pixels_count = std::min<size_t> (batch, points.size () - p);
+
+				alignas(64) std::array<float, batch> real;
+				alignas(64) std::array<float, batch> imag;
+				real.fill (0);
+				imag.fill (0);
+				for (size_t i = 0; i < pixels_count; i++)
+				{
+					auto c = point_to_complex (points[p + i], lower_left, scale);
+					real[i] = c.real ();
+					imag[i] = c.imag ();
+				}
+
+				std::array<size_t, batch> result;
+				if constexpr (cpu_ext == FracUseCPUExt::AVX512) {
+					std::array<__m512, pixels_size> c_real;
+					std::array<__m512, pixels_size> c_imag;
+					std::array<__mmask16, pixels_size> interior;
+					for (size_t j = 0; j < pixels_size; j++)
+					{
+						c_real[j] = _mm512_load_ps (real.data () + j * lanes);
+						c_imag[j] = _mm512_load_ps (imag.data () + j * lanes);
+						long long lanes_left = (long long)pixels_count - (long long)(j * lanes);
+						interior[j] = 0;
+						if (_check_interior) {
+							interior[j] = interior_mask (c_real[j], c_imag[j]);
+							count_skipped (interior[j], lanes_left);
+						}
+						if (lanes_left < (long long)lanes)
+							interior[j] |= lanes_left <= 0 ? 0xffff : (__mmask16)(0xffff << lanes_left);
+					}
+					result = smooth_kernels && _smooth
+						? mandelbrot_avx512<pixels_size, smooth_kernels> (c_real, c_imag, interior)
+						: mandelbrot_avx512<pixels_size, false> (c_real, c_imag, interior);
+				}
+				else {
+					std::array<__m256, pixels_size> c_real;
+					std::array<__m256, pixels_size> c_imag;
+					std::array<__m256, pixels_size> interior;
+					for (size_t j = 0; j < pixels_size; j++)
+					{
+						c_real[j] = _mm256_load_ps (real.data () + j * lanes);
+						c_imag[j] = _mm256_load_ps (imag.data () + j * lanes);
+						long long lanes_left = (long long)pixels_count - (long long)(j * lanes);
+						interior[j] = _mm256_setzero_ps ();
+						if (_check_interior) {
+							interior[j] = interior_mask (c_real[j], c_imag[j]);
+							count_skipped (_mm256_movemask_ps (interior[j]), lanes_left);
+						}
+						if (lanes_left < (long long)lanes)
+							interior[j] = _mm256_or_ps (interior[j], _mm256_cmp_ps (
+								_mm256_set_ps (7, 6, 5, 4, 3, 2, 1, 0),
+								_mm256_set1_ps ((float)lanes_left),
+								_CMP_GE_OQ));
+					}
+					result = smooth_kernels && _smooth
+						? mandelbrot_avx_multiple<pixels_size, smooth_kernels> (c_real, c_imag, interior)
+						: mandelbrot_avx_multiple<pixels_size, false> (c_real, c_imag, interior);
+				}
+
+				for (size_t i = 0; i < pixels_count; i++)
+				{
+					image[points[p + i]] = get_color (result[i], zooming);
+				}
+			}
+		}
+		else {
+			for (auto idx : points)
+			{
+				image[idx] = get_color (iterate_point (point_to_complex (idx, lower_left, scale)), zooming);
+			}
+		}
+	}
+
+	/** Result of a single point, pixel by pixel kernels. With uses_offsets c is the offset from _center. */
+	template<Precision precision = Precision::Double, typename real_type>
+	size_t iterate_point (std::complex<real_type> c) {
+		if constexpr (uses_offsets (precision)) {
+			if (_check_interior && in_cardioid_or_bulb (_center + c)) {
+				_skipped_pixels++;
+				return bounded_result ();
+			}
+			if constexpr (precision == Precision::Perturbation)
+				return mandelbrot_perturbation (c);
+			else
+				return mandelbrot_double_double (c);
+		}
+		else {
+			if (_check_interior && in_cardioid_or_bulb (c)) {
+				_skipped_pixels++;
+				return bounded_result ();
+			}
+			return mandelbrot (c);
+		}
+	}
+
+	/** Points in double precision, see fill_points and fill_row_double */
+	template<Precision precision = Precision::Double>
+	inline
+	void fill_points_double (const std::vector<size_t>& points, pixel_type* image, const FractalZooming& zooming, const complex_d_t& lower_left, const std::array<double, 2>& scale) {
+		if constexpr (uses_avx (cpu_ext) && (!uses_offsets (precision) || uses_fma (cpu_ext))) {
+			constexpr size_t batch = 4 * pixels_size;
+			for (size_t p = 0; p < points.size (); p += batch)
+			{
+				auto pixels_count = std::min<size_t> (batch, points.size () - p);
+
+				alignas(32) std::array<double, batch> real;
+				alignas(32) std::array<double, batch> imag;
+				real.fill (0);
+				imag.fill (0);
+				for (size_t i = 0; i < pixels_count; i++)
+				{
+					auto c = point_to_complex (points[p + i], lower_left, scale);
+					real[i] = c.real ();
+					imag[i] = c.imag ();
+				}
+
+				std::array<__m256d, pixels_size> c_real;
+				std::array<__m256d, pixels_size> c_imag;
+				std::array<__m256d, pixels_size> interior;
+				for (size_t j = 0; j < pixels_size; j++)
+				{
+					c_real[j] = _mm256_load_pd (real.data () + j * 4);
+					c_imag[j] = _mm256_load_pd (imag.data () + j * 4);
+					long long lanes_left = (long long)pixels_count - (long long)(j * 4);
+					interior[j] = _mm256_setzero_pd ();
+					if (_check_interior) {
+						interior[j] = interior_mask_of<precision> (c_real[j], c_imag[j]);
+						count_skipped (_mm256_movemask_pd (interior[j]), lanes_left);
+					}
+					if (lanes_left < 4)
+						interior[j] = _mm256_or_pd (interior[j], _mm256_cmp_pd (
+							_mm256_set_pd (3, 2, 1, 0),
+							_mm256_set1_pd ((double)lanes_left),
+							_CMP_GE_OQ));
+				}
+				auto result = iterate_double<pixels_size, precision> (c_real, c_imag, interior);
+
+				for (size_t i = 0; i < pixels_count; i++)
+				{
+					image[points[p + i]] = get_color (result[i], zooming);
+				}
+			}
+		}
+		else {
+			for (auto idx : points)
+			{
+				image[idx] = get_color (iterate_point<precision> (point_to_complex (idx, lower_left, scale)), zooming);
+			}
+		}
+	}
+
+	inline
+	void fill_8_pixels (size_t x, size_t y, pixel_type* image, const FractalZooming& zooming, const complex_t& lower_left, const std::array<float, 2>& scale) {
+		auto base_idx = y * _image_width + x;
+
+		__m256 c_real;
+		__m256 c_imag;
+		if constexpr (uses_fma (cpu_ext)) {
+			auto c = idx_to_complex_8 (x, y, lower_left, scale);
+			c_real = std::get<0> (c);
+			c_imag = std::get<1> (c);
+		}
+		else {
+			auto c = std::array<complex_t, 8>{
+				idx_to_complex (x, y, lower_left, scale),
+				idx_to_complex (x + 1, y, lower_left, scale),
+				idx_to_complex (x + 2, y, lower_left, scale),
+				idx_to_complex (x + 3, y, lower_left, scale),
+				idx_to_complex (x + 4, y, lower_left, scale),
+				idx_to_complex (x + 5, y, lower_left, scale),
+				idx_to_complex (x + 6, y, lower_left, scale),
+				idx_to_complex (x + 7, y, lower_left, scale),
+			};
+			c_real = _mm256_set_ps (
+				std::get<7> (c).real (), std::get<6> (c).real (),
+				std::get<5> (c).real (), std::get<4> (c).real (),
+				std::get<3> (c).real (), std::get<2> (c).real (),
+				std::get<1> (c).real (), std::get<0> (c).real ()
+			);
+			c_imag = _mm256_set_ps (
+				std::get<7> (c).imag (), std::get<6> (c).imag (),
+				std::get<5> (c).imag (), std::get<4> (c).imag (),
+				std::get<3> (c).imag (), std::get<2> (c).imag (),
+				std::get<1> (c).imag (), std::get<0> (c).imag ()
+			);
+		}
+		auto pixels_count = std::min<size_t> (8, _row_end - x);
+
+		__m256 interior = _mm256_setzero_ps ();
+		if (_check_interior) {
+			interior = interior_mask (c_real, c_imag);
+			count_skipped (_mm256_movemask_ps (interior), pixels_count);
+		}
+		auto result = smooth_kernels && _smooth
+			? mandelbrot_avx<smooth_kernels> (c_real, c_imag, interior)
+			: mandelbrot_avx<false> (c_real, c_imag, interior);
+
+		for (size_t i = 0; i < pixels_count; i++)
+		{
+			image[base_idx + i] = get_color (result[i], zooming);
+		}
+	}
+
+	template<int size = 1>
+	inline
+	void fill_pixels (size_t x, size_t y, pixel_type* image, const FractalZooming& zooming, const complex_t& lower_left, const std::array<float, 2>& scale) {
+		std::array<__m256, size> c_real;
+		std::array<__m256, size> c_imag;
+
+		auto c = idx_to_complex_8 (x, y, lower_left, scale);
+		c_real[0] = std::get<0> (c);
+		c_imag.fill (std::get<1> (c)); // imag will be the same as we fill a row
+		for (size_t i = 1; i < size; i++)
+		{
+			c = idx_to_complex_8 (x + (i * 8), y, lower_left, scale);
+			c_real[i] = std::get<0> (c);
+		}
+
+		std::array<__m256, size> interior;
+		interior.fill (_mm256_setzero_ps ());
+		if (_check_interior) {
+			for (size_t i = 0; i < size; i++)
+			{
+				interior[i] = interior_mask (c_real[i], c_imag[i]);
+				count_skipped (_mm256_movemask_ps (interior[i]), (long long)_row_end - (long long)(x + i * 8));
+			}
+		}
+		auto result = smooth_kernels && _smooth
+			? mandelbrot_avx_multiple<size, smooth_kernels> (c_real, c_imag, interior)
+			: mandelbrot_avx_multiple<size, false> (c_real, c_imag, interior);
+
+		auto base_idx = y * _image_width + x;
+		auto pixels_count = 8 * size;
+		auto overdraw = x + pixels_count < _row_end
+			? 0
+			: (x + pixels_count) - _row_end;
+
+		std::transform (
+			std::begin (result),
+			std::end (result) - overdraw,
+			image + base_idx,
+			[this, &zooming](auto& elem) { return get_color (elem, zooming); }
+		);
+	}
+
+	template<int size = 1>
+	inline
+	void fill_pixels_avx512 (size_t x, size_t y, pixel_type* image, const FractalZooming& zooming, const complex_t& lower_left, const std::array<float, 2>& scale) {
+		std::array<__m512, size> c_real;
+		std::array<__m512, size> c_imag;
+
+		for (size_t i = 0; i < size; i++)
+		{
+			auto c = idx_to_complex_16 (x + (i * 16), y, lower_left, scale);
+			c_real[i] = std::get<0> (c);
+			c_imag[i] = std::get<1> (c);
+		}
+
+		std::array<__mmask16, size> interior;
+		interior.fill (0);
+		if (_check_interior) {
+			for (size_t i = 0; i < size; i++)
+			{
+				interior[i] = interior_mask (c_real[i], c_imag[i]);
+				count_skipped (interior[i], (long long)_row_end - (long long)(x + i * 16));
+			}
+		}
+		auto result = smooth_kernels && _smooth
+			? mandelbrot_avx512<size, smooth_kernels> (c_real, c_imag, interior)
+			: mandelbrot_avx512<size, false> (c_real, c_imag, interior);
+
+		auto base_idx = y * _image_width + x;
+		auto pixels_count = 16 * size;
+		auto overdraw = x + pixels_count < _row_end
+			? 0
+			: (x + pixels_count) - _row_end;
+
+		std::transform (
+			std::begin (result),
+			std::end (result) - overdraw,
+			image + base_idx,
+			[this, &zooming](auto& elem) { return get_color (elem, zooming); }
+		);
+	}
+
+	template<int size = 1, Precision precision = Precision::Double>
+	inline
+	void fill_pixels_double (size_t x, size_t y, pixel_type* image, const FractalZooming& zooming, const complex_d_t& lower_left, const std::array<double, 2>& scale) {
+		std::array<__m256d, size> c_real;
+		std::array<__m256d, size> c_imag;
+
+		for (size_t i = 0; i < size; i++)
+		{
+			auto c = idx_to_complex_4 (x + (i * 4), y, lower_left, scale);
+			c_real[i] = std::get<0> (c);
+			c_imag[i] = std::get<1> (c);
+		}
+
+		std::array<__m256d, size> interior;
+		interior.fill (_mm256_setzero_pd ());
+		if (_check_interior) {
+			for (size_t i = 0; i < size; i++)
+			{
+				interior[i] = interior_mask_of<precision> (c_real[i], c_imag[i]);
+				count_skipped (_mm256_movemask_pd (interior[i]), (long long)_row_end - (long long)(x + i * 4));
+			}
+		}
+		auto result = iterate_double<size, precision> (c_real, c_imag, interior);
+
+		auto base_idx = y * _image_width + x;
+		auto pixels_count = 4 * size;
+		auto overdraw = x + pixels_count < _row_end
+			? 0
+			: (x + pixels_count) - _row_end;
+
+		std::transform (
+			std::begin (result),
+			std::end (result) - overdraw,
+			image + base_idx,
+			[this, &zooming](auto& elem) { return get_color (elem, zooming); }
+		);
+	}
+
+	template<typename real_type>
+	inline
+	std::complex<real_type> idx_to_complex (size_t x, size_t y, std::complex<real_type> lower_left, std::array<real_type, 2> scale) {
+		return lower_left + std::complex<real_type>{
+			x * std::get<0>(scale),
+			(_image_height - y - 1) * std::get<1>(scale)
+		};
+	}
+
+	/** Rounds like the row kernels of this extension, so a point matches its pixel in a row */
+	template<typename real_type>
+	std::complex<real_type> point_to_complex (size_t idx, std::complex<real_type> lower_left, std::array<real_type, 2> scale) {
+		// 32 bit division is a lot cheaper and images stay far below 2^32 pixels
+		size_t x = (uint32_t)idx % (uint32_t)_image_width;
+		size_t y = (uint32_t)idx / (uint32_t)_image_width;
+		if constexpr (uses_fma (cpu_ext)) {
+			return std::complex<real_type>{
+				std::fma ((real_type)x, std::get<0>(scale), lower_left.real()),
+				(_image_height - y - 1) * std::get<1>(scale) + lower_left.imag()
+			};
+		}
+		else {
+			return idx_to_complex (x, y, lower_left, scale);
+		}
+	}
+
+	std::tuple<__m256, __m256> idx_to_complex_8 (size_t x, size_t y, complex_t lower_left, std::array<float, 2> scale) {
+		// real = lower_left.real + x * scale.x;
+		// imag = lower_left.imag + y * scale.y;
+		__m256 scale_real = _mm256_set1_ps (std::get<0>(scale));
+		__m256 ll_real = _mm256_set1_ps (lower_left.real());
+		__m256 xs = _mm256_add_ps (
+			_mm256_set1_ps ((float)x),
+			_mm256_set_ps (7, 6, 5, 4, 3, 2, 1, 0)
+		);
+
+		__m256 real;
+		if constexpr (uses_fma (cpu_ext)) {
+			real = _mm256_fmadd_ps (xs, scale_real, ll_real);
+		}
+		else {
+			real = _mm256_add_ps (_mm256_mul_ps (xs, scale_real), ll_real);
+		}
+		__m256 imag = _mm256_set1_ps (
+			(_image_height - y - 1) * std::get<1>(scale)
+			+ lower_left.imag()
+		); // y is fix as we calculate a 8 cols in a row
+
+		return std::make_tuple (real, imag);
+	}
+
+	std::tuple<__m512, __m512> idx_to_complex_16 (size_t x, size_t y, complex_t lower_left, std::array<float, 2> scale) {
+		__m512 xs = _mm512_add_ps (
+			_mm512_set1_ps ((float)x),
+			_mm512_set_ps (15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0)
+		);
+
+		__m512 real = _mm512_fmadd_ps (
+			xs,
+			_mm512_set1_ps (std::get<0>(scale)),
+			_mm512_set1_ps (lower_left.real())
+		);
+		__m512 imag = _mm512_set1_ps (
+			(_image_height - y - 1) * std::get<1>(scale)
+			+ lower_left.imag()
+		); // y is fix as we calculate a 16 cols in a row
+
+		return std::make_tuple (real, imag);
+	}
+
+	std::tuple<__m256d, __m256d> idx_to_complex_4 (size_t x, size_t y, complex_d_t lower_left, std::array<double, 2> scale) {
+		__m256d xs = _mm256_add_pd (
+			_mm256_set1_pd ((double)x),
+			_mm256_set_pd (3, 2, 1, 0)
+		);
+
+		__m256d real;
+		if constexpr (uses_fma (cpu_ext)) {
+			real = _mm256_fmadd_pd (xs, _mm256_set1_pd (std::get<0>(scale)), _mm256_set1_pd (lower_left.real()));
+		}
+		else {
+			real = _mm256_add_pd (_mm256_mul_pd (xs, _mm256_set1_pd (std::get<0>(scale))), _mm256_set1_pd (lower_left.real()));
+		}
+		__m256d imag = _mm256_set1_pd (
+			(_image_height - y - 1) * std::get<1>(scale)
+			+ lower_left.imag()
+		); // y is fix as we calculate a 4 cols in a row
+
+		return std::make_tuple (real, imag);
+	}
+
+	/**
+	Points inside the main cardioid or the period-2 bulb never escape:
+	  cardioid: q * (q + (x - 1/4)) <= y^2 / 4 with q = (x - 1/4)^2 + y^2
+	  bulb:     (x + 1)^2 + y^2 <= 1/16
+	*/
+	template<typename real_type>
+	static bool in_cardioid_or_bulb (std::complex<real_type> c) {
+		real_type imag_sq = c.imag () * c.imag ();
+		real_type x_q = c.real () - (real_type)0.25;
+		real_type q = x_q * x_q + imag_sq;
+		real_type x_b = c.real () + 1;
+		return q * (q + x_q) <= (real_type)0.25 * imag_sq
+			|| x_b * x_b + imag_sq <= (real_type)0.0625;
+	}
+
+	/** Lanes inside the main cardioid or the period-2 bulb, see in_cardioid_or_bulb */
+	static __m256 interior_mask (__m256 c_real, __m256 c_imag) {
+		__m256 imag_sq = _mm256_mul_ps (c_imag, c_imag);
+		__m256 x_q = _mm256_sub_ps (c_real, _mm256_set1_ps (0.25f));
+		__m256 q = _mm256_add_ps (_mm256_mul_ps (x_q, x_q), imag_sq);
+		__m256 cardioid = _mm256_cmp_ps (
+			_mm256_mul_ps (q, _mm256_add_ps (q, x_q)),
+			_mm256_mul_ps (imag_sq, _mm256_set1_ps (0.25f)),
+			_CMP_LE_OQ
+		);
+
+		__m256 x_b = _mm256_add_ps (c_real, _mm256_set1_ps (1));
+		__m256 bulb = _mm256_cmp_ps (
+			_mm256_add_ps (_mm256_mul_ps (x_b, x_b), imag_sq),
+			_mm256_set1_ps (0.0625f),
+			_CMP_LE_OQ
+		);
+		return _mm256_or_ps (cardioid, bulb);
+	}
+
+	static __mmask16 interior_mask (__m512 c_real, __m512 c_imag) {
+		__m512 imag_sq = _mm512_mul_ps (c_imag, c_imag);
+		__m512 x_q = _mm512_sub_ps (c_real, _mm512_set1_ps (0.25f));
+		__m512 q = _mm512_add_ps (_mm512_mul_ps (x_q, x_q), imag_sq);
+		__mmask16 cardioid = _mm512_cmp_ps_mask (
+			_mm512_mul_ps (q, _mm512_add_ps (q, x_q)),
+			_mm512_mul_ps (imag_sq, _mm512_set1_ps (0.25f)),
+			_CMP_LE_OQ
+		);
+
+		__m512 x_b = _mm512_add_ps (c_real, _mm512_set1_ps (1));
+		__mmask16 bulb = _mm512_cmp_ps_mask (
+			_mm512_add_ps (_mm512_mul_ps (x_b, x_b), imag_sq),
+			_mm512_set1_ps (0.0625f),
+			_CMP_LE_OQ
+		);
+		return cardioid | bulb;
+	}
+
+	static __m256d interior_mask (__m256d c_real, __m256d c_imag) {
+		__m256d imag_sq = _mm256_mul_pd (c_imag, c_imag);
+		__m256d x_q = _mm256_sub_pd (c_real, _mm256_set1_pd (0.25));
+		__m256d q = _mm256_add_pd (_mm256_mul_pd (x_q, x_q), imag_sq);
+		__m256d cardioid = _mm256_cmp_pd (
+			_mm256_mul_pd (q, _mm256_add_pd (q, x_q)),
+			_mm256_mul_pd (imag_sq, _mm256_set1_pd (0.25)),
+			_CMP_LE_OQ
+		);
+
+		__m256d x_b = _mm256_add_pd (c_real, _mm256_set1_pd (1));
+		__m256d bulb = _mm256_cmp_pd (
+			_mm256_add_pd (_mm256_mul_pd (x_b, x_b), imag_sq),
+			_mm256_set1_pd (0.0625),
+			_CMP_LE_OQ
+		);
+		return _mm256_or_pd (cardioid, bulb);
+	}
+
+	/** interior_mask of double lanes, with uses_offsets they are offsets from _center */
+	template<Precision precision>
+	__m256d interior_mask_of (__m256d c_real, __m256d c_imag) const {
+		if constexpr (uses_offsets (precision))
+			return interior_mask (
+				_mm256_add_pd (c_real, _mm256_set1_pd (_center.real ())),
+				_mm256_add_pd (c_imag, _mm256_set1_pd (_center.imag ())));
+		else
+			return interior_mask (c_real, c_imag);
+	}
+
+	/** Counts the lanes of an interior mask which are inside the image */
+	void count_skipped (unsigned int interior, long long pixels_count) {
+		if (pixels_count <= 0)
+			return;
+		if (pixels_count < 32)
+			interior &= (1u << pixels_count) - 1;
+		_skipped_pixels += std::bitset<32> (interior).count ();
+	}
+
+	/**
+	Color of a result of the kernels: an iteration count, or with smooth
+	coloring already the entry of the gradient.
+	*/
+	inline
+	pixel_type get_color (size_t result, const FractalZooming& zooming) {
+		// bounded points get the last color, independent of the budget of this frame
+		size_t color = _smooth || result < iterations () - 1 ? result : zooming.color_map.size () - 1;
+		if constexpr (std::is_same_v<pixel_type, palette_index_t>)
+			return zooming.palette_index (color);
+		else if constexpr (std::is_same_v<pixel_type, iteration_count_t>)
+			return (iteration_count_t)color;
+		else
+			return _colors[color];
+	}
+
+	/** Result of a bounded point */
+	size_t bounded_result () const {
+		return _smooth ? (size_t)_gradient_cycle : iterations () - 1;
+	}
+
+	/**
+	Normalized iteration count nu = count + 1 - log2 (log |z| / log bound) of
+	an escaped point, which runs continuously from one count to the next. Maps
+	it onto the entries of the gradient escaped points cycle through.
+	Every kernel compares |z|^2 with FRACTAL_BOUND, so the escape radius is
+	sqrt (bound) and log_ratio is log |z|^2 / log bound.
+	*/
+	size_t smooth_entry (size_t count, float log_ratio) const {
+		float t = ((float)count + 1 - std::log2 (log_ratio)) * _gradient_step;
+		t -= _gradient_cycle * std::floor (t / _gradient_cycle);
+		return std::min ((size_t)t, (size_t)_gradient_cycle - 1);
+	}
+
+	template<typename real_type>
+	size_t mandelbrot (std::complex<real_type> c) {
+		std::complex<real_type> z;
+		std::complex<real_type> saved;
+		size_t save_at = 1;
+		for (size_t i = 0; i < iterations (); i++)
+		{
+			z = z * z + c;
+			// |z|^2 like the vector kernels, so every extension escapes at the same radius
+			auto mag = std::norm (z);
+			if (mag > FRACTAL_BOUND) { // divereged
+				return _smooth ? smooth_entry (i, std::log2 (mag) / log2_bound) : i;
+			}
+
+			if (_check_periodicity) {
+				if (i == save_at) {
+					saved = z;
+					save_at *= 2;
+				}
+				else if (std::abs (z.real () - saved.real ()) < FRACTAL_PERIOD_EPSILON
+					&& std::abs (z.imag () - saved.imag ()) < FRACTAL_PERIOD_EPSILON) {
+					break; // cycle
+				}
+			}
+		}
+		// bounded
+		return bounded_result ();
+	}
+
+	/**
+	Point _center + dc, iterated as its offset delta from the reference orbit Z:
+	  delta_n+1 = (2 Z_n + delta_n) delta_n + dc,  z_n = Z_n + delta_n
+	The offsets stay as small as the frame, so double resolves them at any
+	depth. Where |z| gets smaller than |delta| the offset lost its precision
+	against the reference, and at the end of the reference nothing is left to
+	follow. Both times z itself becomes the offset from the start of the
+	reference (Z_0 = 0), which keeps the iteration exact (rebasing).
+	Compares |z|^2 with the bound as the vector kernels do. Starts after the
+	iterations of the series, see FractalZooming::frame_series.
+	*/
+	size_t mandelbrot_perturbation (complex_d_t dc) {
+		const double* ref_real = _reference->real.data ();
+		const double* ref_imag = _reference->imag.data ();
+		const size_t last = _reference->size () - 1;
+		complex_d_t u = dc / _series.radius;
+		complex_d_t delta = u * (_series.a + u * (_series.b + u * _series.c));
+		double d_real = delta.real ();
+		double d_imag = delta.imag ();
+		size_t m = _series.skipped;
+		for (size_t i = _series.skipped; i < iterations (); i++)
+		{
+			double sum_real = 2 * ref_real[m] + d_real;
+			double sum_imag = 2 * ref_imag[m] + d_imag;
+			double next_real = sum_real * d_real - sum_imag * d_imag + dc.real ();
+			d_imag = sum_real * d_imag + sum_imag * d_real + dc.imag ();
+			d_real = next_real;
+			m++;
+
+			double z_real = ref_real[m] + d_real;
+			double z_imag = ref_imag[m] + d_imag;
+			double mag = z_real * z_real + z_imag * z_imag;
+			if (mag > FRACTAL_BOUND)
+				return _smooth ? smooth_entry (i, (float)std::log2 (mag) / log2_bound) : i;
+
+			if (mag < d_real * d_real + d_imag * d_imag || m == last) {
+				d_real = z_real;
+				d_imag = z_imag;
+				m = 0;
+			}
+		}
+		return bounded_result ();
+	}
+
+	/**
+	Point _center + dc in double-double, see dd_real. The sum keeps the
+	digits of the center past double, so the pixels keep their distance at
+	~2^-100 of |c| instead of the 2^-50 of double.
+	*/
+	size_t mandelbrot_double_double (complex_d_t dc) {
+		dd_real c_real = _exact_center.real + dc.real ();
+		dd_real c_imag = _exact_center.imag + dc.imag ();
+		dd_real z_real;
+		dd_real z_imag;
+		for (size_t i = 0; i < iterations (); i++)
+		{
+			dd_real prod = z_real * z_imag;
+			z_real = z_real * z_real - z_imag * z_imag + c_real;
+			z_imag = prod + prod + c_imag;
+
+			double mag = z_real.hi * z_real.hi + z_imag.hi * z_imag.hi;
+			if (mag > FRACTAL_BOUND)
+				return _smooth ? smooth_entry (i, (float)std::log2 (mag) / log2_bound) : i;
+		}
+		return bounded_result ();
+	}
+
+	/**
+	Lanes still iterating are tracked with a compare mask, their iteration
+	counters stay in a register and are only incremented while they are
+	active. One movemask per iteration tells if all lanes escaped. With smooth
+	the lanes also keep the |z|^2 they escaped with, a compile time choice as
+	the extra registers slow down the loop without it.
+	*/
+	template<bool smooth = false>
+	std::array<size_t, 8> mandelbrot_avx (__m256 c_real, __m256 c_imag, __m256 interior) {
+		// 8 32-bit float -> 4 complex numbers
+		__m256 const_2 = _mm256_set1_ps (2);
+		__m256 bound = _mm256_set1_ps (FRACTAL_BOUND);
+		__m256 z_real = _mm256_set1_ps (0);
+		__m256 z_imag = _mm256_set1_ps (0);
+		__m256 saved_real = z_real;
+		__m256 saved_imag = z_imag;
+		size_t save_at = 1;
+		// |z|^2 of the lanes when they escaped, for the smooth coloring
+		__m256 escaped = _mm256_set1_ps (FRACTAL_BOUND);
+
+		// interior lanes are known to be bounded and are not iterated at all
+		__m256 active = _mm256_andnot_ps (interior, _mm256_castsi256_ps (_mm256_set1_epi32 (-1)));
+		counter_t count = bounded_counter (interior);
+		for (size_t i = 0; i < iterations () && _mm256_movemask_ps (active); i++)
+		{
+			/*
+			z.real = z.real * z.real - z.imag * z.imag + c.real;
+			z.imag = 2 * z.real * z.imag + c.imag;
+			*/
+			__m256 prod = _mm256_mul_ps (z_real, z_imag);
+			z_real = _mm256_add_ps (
+				_mm256_sub_ps (
+					_mm256_mul_ps (z_real, z_real),
+					_mm256_mul_ps (z_imag, z_imag)
+				),
+				c_real
+			);
+
+			if constexpr (uses_fma (cpu_ext)) {
+				z_imag = _mm256_fmadd_ps (prod, const_2, c_imag);
+			}
+			else {
+				z_imag = _mm256_add_ps (
+					_mm256_mul_ps (
+						prod,
+						const_2
+					),
+					c_imag
+				);
+			}
+
+			__m256 mag = _mm256_add_ps (
+				_mm256_mul_ps (z_real, z_real),
+				_mm256_mul_ps (z_imag, z_imag)
+			);
+			if constexpr (smooth)
+				escaped = record_escaped (escaped, mag, active);
+			active = _mm256_and_ps (active, _mm256_cmp_ps (mag, bound, _CMP_LE_OQ));
+			count = count_active (count, active);
+
+			if (_check_periodicity) {
+				if (i == save_at) {
+					saved_real = z_real;
+					saved_imag = z_imag;
+					save_at *= 2;
+				}
+				else {
+					active = stop_periodic (count, active, z_real, z_imag, saved_real, saved_imag);
+				}
+			}
+		}
+
+		std::array<size_t, 8> result;
+		if constexpr (smooth)
+			store_entries (count, escaped, result.data ());
+		else
+			store_counts (count, result.data ());
+		return result;
+	}
+
+	template<int size = 1, bool smooth = false>
+	std::array<size_t, size * 8> mandelbrot_avx_multiple (std::array<__m256, size> c_real, std::array<__m256, size> c_imag, std::array<__m256, size> interior) {
+		// 8 32-bit float -> 4 complex numbers
+		__m256 const_2 = _mm256_set1_ps (2);
+		__m256 bound = _mm256_set1_ps (FRACTAL_BOUND);
+		std::array<__m256, size> z_real;
+		z_real.fill (_mm256_set1_ps (0));
+		std::array<__m256, size> z_imag;
+		z_imag.fill (_mm256_set1_ps (0));
+		std::array<__m256, size> saved_real = z_real;
+		std::array<__m256, size> saved_imag = z_imag;
+		size_t save_at = 1;
+		// |z|^2 of the lanes when they escaped, for the smooth coloring
+		std::array<__m256, size> escaped;
+		escaped.fill (_mm256_set1_ps (FRACTAL_BOUND));
+
+		// interior lanes are known to be bounded and are not iterated at all
+		std::array<__m256, size> active;
+		std::array<counter_t, size> count;
+		// bit j is set while vector j has lanes left to iterate
+		unsigned int block_active = 0;
+		for (size_t j = 0; j < size; j++)
+		{
+			active[j] = _mm256_andnot_ps (interior[j], _mm256_castsi256_ps (_mm256_set1_epi32 (-1)));
+			count[j] = bounded_counter (interior[j]);
+			if (_mm256_movemask_ps (active[j]))
+				block_active |= 1u << j;
+		}
+		for (size_t i = 0; i < iterations () && block_active; i++)
+		{
+			for (size_t j = 0; j < size; j++)
+			{
+				if (!(block_active & (1u << j)))
+					continue;
+
+				/*
+				z.real = z.real * z.real - z.imag * z.imag + c.real;
+				z.imag = 2 * z.real * z.imag + c.imag;
+				*/
+				__m256 prod = _mm256_mul_ps (z_real[j], z_imag[j]);
+				z_real[j] = _mm256_add_ps (
+					_mm256_sub_ps (
+						_mm256_mul_ps (z_real[j], z_real[j]),
+						_mm256_mul_ps (z_imag[j], z_imag[j])
+					),
+					c_real[j]
+				);
+
+				if constexpr (uses_fma (cpu_ext)) {
+					z_imag[j] = _mm256_fmadd_ps (prod, const_2, c_imag[j]);
+				}
+				else {
+					z_imag[j] = _mm256_add_ps (
+						_mm256_mul_ps (
+							prod,
+							const_2
+						),
+						c_imag[j]
+					);
+				}
+
+				__m256 mag = _mm256_add_ps (
+					_mm256_mul_ps (z_real[j], z_real[j]),
+					_mm256_mul_ps (z_imag[j], z_imag[j])
+				);
+				if constexpr (smooth)
+					escaped[j] = record_escaped (escaped[j], mag, active[j]);
+				active[j] = _mm256_and_ps (active[j], _mm256_cmp_ps (mag, bound, _CMP_LE_OQ));
+				count[j] = count_active (count[j], active[j]);
+
+				if (_check_periodicity) {
+					if (i == save_at) {
+						saved_real[j] = z_real[j];
+						saved_imag[j] = z_imag[j];
+					}
+					else {
+						active[j] = stop_periodic (count[j], active[j], z_real[j], z_imag[j], saved_real[j], saved_imag[j]);
+					}
+				}
+
+				if (_mm256_movemask_ps (active[j]) == 0)
+					block_active &= ~(1u << j);
+			}
+
+			if (i == save_at)
+				save_at *= 2;
+		}
+
+		std::array<size_t, size * 8> result;
+		for (size_t j = 0; j < size; j++)
+		{
+			if constexpr (smooth)
+				store_entries (count[j], escaped[j], result.data () + j * 8);
+			else
+				store_counts (count[j], result.data () + j * 8);
+		}
+		return result;
+	}
+
+	/**
+	Per lane iteration counters of the AVX kernels. AVX has no 256 bit integer
+	arithmetic, so there they are counted as floats (exact up to 2^24).
+	*/
+	using counter_t = std::conditional_t<uses_fma (cpu_ext), __m256i, __m256>;
+
+	/** Counters start at zero, lanes known to be bounded start at iterations () - 1 */
+	counter_t bounded_counter (__m256 bounded) {
+		if constexpr (uses_fma (cpu_ext))
+			return _mm256_and_si256 (_mm256_castps_si256 (bounded), _mm256_set1_epi32 ((int)iterations () - 1));
+		else
+			return _mm256_and_ps (bounded, _mm256_set1_ps ((float)iterations () - 1));
+	}
+
+	/** Sets the counters of the given lanes to iterations () - 1 */
+	counter_t mark_bounded (counter_t count, __m256 bounded) {
+		if constexpr (uses_fma (cpu_ext))
+			return _mm256_blendv_epi8 (count, _mm256_set1_epi32 ((int)iterations () - 1), _mm256_castps_si256 (bounded));
+		else
+			return _mm256_blendv_ps (count, _mm256_set1_ps ((float)iterations () - 1), bounded);
+	}
+
+	/**
+	Brent's cycle detection: an orbit which returns to the point saved at the
+	last power of two iteration is periodic and will never escape. Such lanes
+	are marked as bounded and removed from the active mask.
+	*/
+	__m256 stop_periodic (counter_t& count, __m256 active, __m256 z_real, __m256 z_imag, __m256 saved_real, __m256 saved_imag) {
+		const __m256 sign = _mm256_set1_ps (-0.0f);
+		const __m256 epsilon = _mm256_set1_ps (FRACTAL_PERIOD_EPSILON);
+		__m256 periodic = _mm256_and_ps (
+			_mm256_cmp_ps (_mm256_andnot_ps (sign, _mm256_sub_ps (z_real, saved_real)), epsilon, _CMP_LT_OQ),
+			_mm256_cmp_ps (_mm256_andnot_ps (sign, _mm256_sub_ps (z_imag, saved_imag)), epsilon, _CMP_LT_OQ)
+		);
+		periodic = _mm256_and_ps (periodic, active);
+
+		count = mark_bounded (count, periodic);
+		return _mm256_andnot_ps (periodic, active);
+	}
+
+	/** Adds one to every lane set in the active mask */
+	static counter_t count_active (counter_t count, __m256 active) {
+		if constexpr (uses_fma (cpu_ext))
+			return _mm256_sub_epi32 (count, _mm256_castps_si256 (active)); // active lanes are -1
+		else
+			return _mm256_add_ps (count, _mm256_and_ps (active, _mm256_set1_ps (1)));
+	}
+
+	/** Bounded lanes were counted iterations () times, they end up as iterations () - 1 */
+	void store_counts (counter_t count, size_t* result) {
+		alignas(32) std::array<int, 8> counts;
+		if constexpr (uses_fma (cpu_ext)) {
+			count = _mm256_min_epi32 (count, _mm256_set1_epi32 ((int)iterations () - 1));
+			_mm256_store_si256 (reinterpret_cast<__m256i*> (counts.data ()), count);
+		}
+		else {
+			count = _mm256_min_ps (count, _mm256_set1_ps ((float)iterations () - 1));
+			_mm256_store_si256 (reinterpret_cast<__m256i*> (counts.data ()), _mm256_cvttps_epi32 (count));
+		}
+		std::copy (std::begin (counts), std::end (counts), result);
+	}
+
+	/**
+	Active lanes stay within the bound but in the iteration they escape, so the
+	largest |z|^2 while active is the one they escaped with, which takes two
+	cheap instructions instead of a blend.
+	*/
+	static __m256 record_escaped (__m256 escaped, __m256 mag, __m256 active) {
+		return _mm256_max_ps (escaped, _mm256_and_ps (mag, active));
+	}
+
+	/** Entries of the gradient of the lanes, see smooth_entry */
+	void store_entries (counter_t count, __m256 escaped, size_t* result) {
+		__m256 counts;
+		if constexpr (uses_fma (cpu_ext))
+			counts = _mm256_cvtepi32_ps (count);
+		else
+			counts = count;
+		// |z|^2 is compared to the bound, so log |z| / log bound = log2 |z|^2 / log2 bound
+		__m256 log_ratio = _mm256_mul_ps (log2_approx (escaped), _mm256_set1_ps (1 / log2_bound));
+		__m256 t = _mm256_mul_ps (
+			_mm256_sub_ps (_mm256_add_ps (counts, _mm256_set1_ps (1)), log2_near_1 (log_ratio)),
+			_mm256_set1_ps (_gradient_step));
+		const __m256 cycle = _mm256_set1_ps (_gradient_cycle);
+		t = _mm256_sub_ps (t, _mm256_mul_ps (cycle, _mm256_floor_ps (_mm256_mul_ps (t, _mm256_set1_ps (1 / _gradient_cycle)))));
+		t = _mm256_min_ps (_mm256_floor_ps (t), _mm256_sub_ps (cycle, _mm256_set1_ps (1)));
+		// bounded lanes kept |z|^2 within the bound, the count of a lane escaping in the last iteration equals theirs
+		__m256 bounded = _mm256_cmp_ps (escaped, _mm256_set1_ps (FRACTAL_BOUND), _CMP_LE_OQ);
+		t = _mm256_blendv_ps (t, cycle, bounded);
+
+		alignas(32) std::array<int, 8> entries;
+		_mm256_store_si256 (reinterpret_cast<__m256i*> (entries.data ()), _mm256_cvttps_epi32 (t));
+		std::copy (std::begin (entries), std::end (entries), result);
+	}
+
+	/** 16 lanes at a time, see store_entries */
+	void store_entries (__m512i count, __m512 escaped, size_t* result) {
+		__m512 counts = _mm512_cvtepi32_ps (count);
+		__m512 log_ratio = _mm512_mul_ps (log2_approx (escaped), _mm512_set1_ps (1 / log2_bound));
+		__m512 t = _mm512_mul_ps (
+			_mm512_sub_ps (_mm512_add_ps (counts, _mm512_set1_ps (1)), log2_near_1 (log_ratio)),
+			_mm512_set1_ps (_gradient_step));
+		const __m512 cycle = _mm512_set1_ps (_gradient_cycle);
+		t = _mm512_sub_ps (t, _mm512_mul_ps (cycle, _mm512_floor_ps (_mm512_mul_ps (t, _mm512_set1_ps (1 / _gradient_cycle)))));
+		t = _mm512_min_ps (_mm512_floor_ps (t), _mm512_sub_ps (cycle, _mm512_set1_ps (1)));
+		__mmask16 bounded = _mm512_cmp_ps_mask (escaped, _mm512_set1_ps (FRACTAL_BOUND), _CMP_LE_OQ);
+		t = _mm512_mask_mov_ps (t, bounded, cycle);
+
+		std::array<int, 16> entries;
+		_mm512_storeu_si512 (entries.data (), _mm512_cvttps_epi32 (t));
+		std::copy (std::begin (entries), std::end (entries), result);
+	}
+
+	static inline const float log2_bound = std::log2 ((float)FRACTAL_BOUND);
+
+	/**
+	log2 of positive normal floats, the error is below 1.5e-4. The bits of a
+	float read as an integer are 2^23 (exponent + 127 + f) with the mantissa
+	1 + f, so they are log2 up to the error of log2 (1 + f) ~ f, which the
+	polynomial f (1 - f) (a + b f + c f^2) corrects.
+	*/
+	static __m256 log2_approx (__m256 x) {
+		__m256 log = _mm256_sub_ps (
+			_mm256_mul_ps (_mm256_cvtepi32_ps (_mm256_castps_si256 (x)), _mm256_set1_ps (1.0f / (1 << 23))),
+			_mm256_set1_ps (127));
+		const __m256 one = _mm256_set1_ps (1);
+		__m256 mantissa = _mm256_or_ps (
+			_mm256_and_ps (x, _mm256_castsi256_ps (_mm256_set1_epi32 (0x007fffff))),
+			one);
+		__m256 f = _mm256_sub_ps (mantissa, one);
+		__m256 poly = _mm256_add_ps (_mm256_mul_ps (f, _mm256_set1_ps (log2_c)), _mm256_set1_ps (log2_b));
+		poly = _mm256_add_ps (_mm256_mul_ps (f, poly), _mm256_set1_ps (log2_a));
+		poly = _mm256_mul_ps (poly, _mm256_mul_ps (f, _mm256_sub_ps (one, f)));
+		return _mm256_add_ps (log, poly);
+	}
+
+	/** AVX-512 reads exponent and mantissa directly, see log2_approx */
+	static __m512 log2_approx (__m512 x) {
+		const __m512 one = _mm512_set1_ps (1);
+		__m512 f = _mm512_sub_ps (_mm512_getmant_ps (x, _MM_MANT_NORM_1_2, _MM_MANT_SIGN_zero), one);
+		__m512 poly = _mm512_fmadd_ps (f, _mm512_set1_ps (log2_c), _mm512_set1_ps (log2_b));
+		poly = _mm512_fmadd_ps (f, poly, _mm512_set1_ps (log2_a));
+		poly = _mm512_mul_ps (poly, _mm512_mul_ps (f, _mm512_sub_ps (one, f)));
+		return _mm512_add_ps (_mm512_add_ps (_mm512_getexp_ps (x), f), poly);
+	}
+
+	/**
+	log2 of x in [1, 2] without the exponent, see log2_approx. The ratio of the
+	logarithms is in (1, 2] up to the distance of c to the origin, slightly
+	above 2 the polynomial is still accurate to ~1e-3.
+	*/
+	static __m256 log2_near_1 (__m256 x) {
+		const __m256 one = _mm256_set1_ps (1);
+		__m256 f = _mm256_sub_ps (x, one);
+		__m256 poly = _mm256_add_ps (_mm256_mul_ps (f, _mm256_set1_ps (log2_c)), _mm256_set1_ps (log2_b));
+		poly = _mm256_add_ps (_mm256_mul_ps (f, poly), _mm256_set1_ps (log2_a));
+		return _mm256_add_ps (f, _mm256_mul_ps (poly, _mm256_mul_ps (f, _mm256_sub_ps (one, f))));
+	}
+
+	static __m512 log2_near_1 (__m512 x) {
+		const __m512 one = _mm512_set1_ps (1);
+		__m512 f = _mm512_sub_ps (x, one);
+		__m512 poly = _mm512_fmadd_ps (f, _mm512_set1_ps (log2_c), _mm512_set1_ps (log2_b));
+		poly = _mm512_fmadd_ps (f, poly, _mm512_set1_ps (log2_a));
+		return _mm512_fmadd_ps (poly, _mm512_mul_ps (f, _mm512_sub_ps (one, f)), f);
+	}
+
+	static constexpr float log2_a = 0.43807325f;
+	static constexpr float log2_b = -0.23669342f;
+	static constexpr float log2_c = 0.08030730f;
+
+	/**
+	16 pixels per vector. Lanes still iterating are tracked in a mask register
+	and their iteration counters are only incremented while they are active, so
+	the loop needs no scalar per-lane checks and stops once every lane escaped.
+	*/
+	template<int size = 1, bool smooth = false>
+	std::array<size_t, size * 16> mandelbrot_avx512 (std::array<__m512, size> c_real, std::array<__m512, size> c_imag, std::array<__mmask16, size> interior) {
+		const __m512 const_2 = _mm512_set1_ps (2);
+		const __m512 bound = _mm512_set1_ps (FRACTAL_BOUND);
+		const __m512i one = _mm512_set1_epi32 (1);
+
+		std::array<__m512, size> z_real;
+		z_real.fill (_mm512_setzero_ps ());
+		std::array<__m512, size> z_imag;
+		z_imag.fill (_mm512_setzero_ps ());
+		std::array<__m512, size> saved_real = z_real;
+		std::array<__m512, size> saved_imag = z_imag;
+		size_t save_at = 1;
+		const __m512 epsilon = _mm512_set1_ps (FRACTAL_PERIOD_EPSILON);
+		// |z|^2 of the lanes when they escaped, for the smooth coloring
+		std::array<__m512, size> escaped;
+		escaped.fill (bound);
+		// interior lanes are known to be bounded and are not iterated at all
+		std::array<__m512i, size> count;
+		std::array<__mmask16, size> active;
+		// bit j is set while vector j has lanes left to iterate
+		unsigned int block_active = 0;
+		for (size_t j = 0; j < size; j++)
+		{
+			count[j] = _mm512_maskz_mov_epi32 (interior[j], _mm512_set1_epi32 ((int)iterations () - 1));
+			active[j] = ~interior[j];
+			if (active[j])
+				block_active |= 1u << j;
+		}
+		for (size_t i = 0; i < iterations () && block_active; i++)
+		{
+			for (size_t j = 0; j < size; j++)
+			{
+				if (!(block_active & (1u << j)))
+					continue;
+
+				/*
+				z.real = z.real * z.real - z.imag * z.imag + c.real;
+				z.imag = 2 * z.real * z.imag + c.imag;
+				*/
+				__m512 real_sq = _mm512_mul_ps (z_real[j], z_real[j]);
+				__m512 imag_sq = _mm512_mul_ps (z_imag[j], z_imag[j]);
+				__m512 prod = _mm512_mul_ps (z_real[j], z_imag[j]);
+				z_real[j] = _mm512_add_ps (_mm512_sub_ps (real_sq, imag_sq), c_real[j]);
+				z_imag[j] = _mm512_fmadd_ps (prod, const_2, c_imag[j]);
+
+				__m512 mag = _mm512_add_ps (
+					_mm512_mul_ps (z_real[j], z_real[j]),
+					_mm512_mul_ps (z_imag[j], z_imag[j])
+				);
+				if constexpr (smooth)
+					escaped[j] = _mm512_mask_mov_ps (escaped[j], active[j], mag);
+				active[j] = _mm512_mask_cmp_ps_mask (active[j], mag, bound, _CMP_LE_OQ);
+				count[j] = _mm512_mask_add_epi32 (count[j], active[j], count[j], one);
+
+				if (_check_periodicity) {
+					if (i == save_at) {
+						saved_real[j] = z_real[j];
+						saved_imag[j] = z_imag[j];
+					}
+					else {
+						// see stop_periodic
+						__mmask16 periodic = _mm512_mask_cmp_ps_mask (
+							active[j],
+							_mm512_abs_ps (_mm512_sub_ps (z_real[j], saved_real[j])), epsilon, _CMP_LT_OQ);
+						periodic = _mm512_mask_cmp_ps_mask (
+							periodic,
+							_mm512_abs_ps (_mm512_sub_ps (z_imag[j], saved_imag[j])), epsilon, _CMP_LT_OQ);
+						count[j] = _mm512_mask_mov_epi32 (count[j], periodic, _mm512_set1_epi32 ((int)iterations () - 1));
+						active[j] &= ~periodic;
+					}
+				}
+
+				if (!active[j])
+					block_active &= ~(1u << j);
+			}
+
+			if (i == save_at)
+				save_at *= 2;
+		}
+
+		std::array<size_t, size * 16> result;
+		if constexpr (smooth) {
+			for (size_t j = 0; j < size; j++)
+			{
+				store_entries (count[j], escaped[j], result.data () + j * 16);
+			}
+			return result;
+		}
+
+		// bounded lanes were counted iterations () times
+		const __m512i max_count = _mm512_set1_epi32 ((int)iterations () - 1);
+		std::array<int, size * 16> counts;
+		for (size_t j = 0; j < size; j++)
+		{
+			_mm512_storeu_si512 (counts.data () + j * 16, _mm512_min_epi32 (count[j], max_count));
+		}
+
+		std::copy (std::begin (counts), std::end (counts), std::begin (result));
+		return result;
+	}
+
+	/**
+	4 pixels per vector in double precision, see mandelbrot_avx_multiple. The
+	counters are doubles as well, which needs no AVX2 and keeps them in the
+	lanes of their pixels.
+	*/
+	template<int size = 1, bool smooth = false>
+	std::array<size_t, size * 4> mandelbrot_avx_double (std::array<__m256d, size> c_real, std::array<__m256d, size> c_imag, std::array<__m256d, size> interior) {
+		const __m256d const_2 = _mm256_set1_pd (2);
+		const __m256d bound = _mm256_set1_pd (FRACTAL_BOUND);
+		const __m256d one = _mm256_set1_pd (1);
+		const __m256d max_count = _mm256_set1_pd ((double)iterations () - 1);
+		const __m256d sign = _mm256_set1_pd (-0.0);
+		const __m256d epsilon = _mm256_set1_pd (FRACTAL_PERIOD_EPSILON);
+
+		std::array<__m256d, size> z_real;
+		z_real.fill (_mm256_setzero_pd ());
+		std::array<__m256d, size> z_imag;
+		z_imag.fill (_mm256_setzero_pd ());
+		std::array<__m256d, size> saved_real = z_real;
+		std::array<__m256d, size> saved_imag = z_imag;
+		size_t save_at = 1;
+		// |z|^2 of the lanes when they escaped, see record_escaped
+		std::array<__m256d, size> escaped;
+		escaped.fill (bound);
+
+		// interior lanes are known to be bounded and are not iterated at all
+		std::array<__m256d, size> active;
+		std::array<__m256d, size> count;
+		// bit j is set while vector j has lanes left to iterate
+		unsigned int block_active = 0;
+		for (size_t j = 0; j < size; j++)
+		{
+			active[j] = _mm256_andnot_pd (interior[j], _mm256_castsi256_pd (_mm256_set1_epi64x (-1)));
+			count[j] = _mm256_and_pd (interior[j], max_count);
+			if (_mm256_movemask_pd (active[j]))
+				block_active |= 1u << j;
+		}
+		for (size_t i = 0; i < iterations () && block_active; i++)
+		{
+			for (size_t j = 0; j < size; j++)
+			{
+				if (!(block_active & (1u << j)))
+					continue;
+
+				__m256d prod = _mm256_mul_pd (z_real[j], z_imag[j]);
+				z_real[j] = _mm256_add_pd (
+					_mm256_sub_pd (
+						_mm256_mul_pd (z_real[j], z_real[j]),
+						_mm256_mul_pd (z_imag[j], z_imag[j])
+					),
+					c_real[j]
+				);
+
+				if constexpr (uses_fma (cpu_ext)) {
+					z_imag[j] = _mm256_fmadd_pd (prod, const_2, c_imag[j]);
+				}
+				else {
+					z_imag[j] = _mm256_add_pd (_mm256_mul_pd (prod, const_2), c_imag[j]);
+				}
+
+				__m256d mag = _mm256_add_pd (
+					_mm256_mul_pd (z_real[j], z_real[j]),
+					_mm256_mul_pd (z_imag[j], z_imag[j])
+				);
+				if constexpr (smooth)
+					escaped[j] = _mm256_max_pd (escaped[j], _mm256_and_pd (mag, active[j]));
+				active[j] = _mm256_and_pd (active[j], _mm256_cmp_pd (mag, bound, _CMP_LE_OQ));
+				count[j] = _mm256_add_pd (count[j], _mm256_and_pd (active[j], one));
+
+				if (_check_periodicity) {
+					if (i == save_at) {
+						saved_real[j] = z_real[j];
+						saved_imag[j] = z_imag[j];
+					}
+					else {
+						// see stop_periodic
+						__m256d periodic = _mm256_and_pd (
+							_mm256_cmp_pd (_mm256_andnot_pd (sign, _mm256_sub_pd (z_real[j], saved_real[j])), epsilon, _CMP_LT_OQ),
+							_mm256_cmp_pd (_mm256_andnot_pd (sign, _mm256_sub_pd (z_imag[j], saved_imag[j])), epsilon, _CMP_LT_OQ)
+						);
+						periodic = _mm256_and_pd (periodic, active[j]);
+						count[j] = _mm256_blendv_pd (count[j], max_count, periodic);
+						active[j] = _mm256_andnot_pd (periodic, active[j]);
+					}
+				}
+
+				if (_mm256_movemask_pd (active[j]) == 0)
+					block_active &= ~(1u << j);
+			}
+
+			if (i == save_at)
+				save_at *= 2;
+		}
+
+		return double_results<size, smooth> (count, escaped);
+	}
+
+	/**
+	4 offsets from _center per vector, see mandelbrot_perturbation and
+	mandelbrot_avx_double. Every lane follows the reference orbit at its own
+	index m. Until a lane of a vector rebases on its own the lanes share their
+	index and the reference is broadcast, afterwards it is gathered. There is
+	no periodicity check, the bounded points of a deep frame lie at the border
+	of the set, whose cycles are longer than any budget.
+	*/
+	template<int size = 1, bool smooth = false>
+	std::array<size_t, size * 4> mandelbrot_avx_perturbation (std::array<__m256d, size> dc_real, std::array<__m256d, size> dc_imag, std::array<__m256d, size> interior) {
+		const double* ref_real = _reference->real.data ();
+		const double* ref_imag = _reference->imag.data ();
+		const __m256i last = _mm256_set1_epi64x ((long long)_reference->size () - 1);
+		const __m256i step = _mm256_set1_epi64x (1);
+		const __m256d const_2 = _mm256_set1_pd (2);
+		const __m256d bound = _mm256_set1_pd (FRACTAL_BOUND);
+		const __m256d one = _mm256_set1_pd (1);
+		const __m256d max_count = _mm256_set1_pd ((double)iterations () - 1);
+
+		// offsets delta from the reference at index m, whose point is ref
+		std::array<__m256d, size> d_real;
+		d_real.fill (_mm256_setzero_pd ());
+		std::array<__m256d, size> d_imag = d_real;
+		std::array<__m256d, size> ref_r = d_real;
+		std::array<__m256d, size> ref_i = d_real;
+		std::array<__m256i, size> m;
+		m.fill (_mm256_set1_epi64x ((long long)_series.skipped));
+		// index of all lanes of a vector, diverged once they differ
+		constexpr size_t diverged = ~size_t{ 0 };
+		std::array<size_t, size> shared_m;
+		shared_m.fill (_series.skipped);
+		ref_r.fill (_mm256_set1_pd (ref_real[_series.skipped]));
+		ref_i.fill (_mm256_set1_pd (ref_imag[_series.skipped]));
+		std::array<__m256d, size> escaped;
+		escaped.fill (bound);
+
+		std::array<__m256d, size> active;
+		std::array<__m256d, size> count;
+		unsigned int block_active = 0;
+		for (size_t j = 0; j < size; j++)
+		{
+			active[j] = _mm256_andnot_pd (interior[j], _mm256_castsi256_pd (_mm256_set1_epi64x (-1)));
+			count[j] = _mm256_blendv_pd (_mm256_set1_pd ((double)_series.skipped), max_count, interior[j]);
+			if (_mm256_movemask_pd (active[j]))
+				block_active |= 1u << j;
+			series_delta (dc_real[j], dc_imag[j], d_real[j], d_imag[j]);
+		}
+		for (size_t i = _series.skipped; i < iterations () && block_active; i++)
+		{
+			for (size_t j = 0; j < size; j++)
+			{
+				if (!(block_active & (1u << j)))
+					continue;
+
+				// delta = (2 ref + delta) delta + dc
+				__m256d sum_real = _mm256_fmadd_pd (ref_r[j], const_2, d_real[j]);
+				__m256d sum_imag = _mm256_fmadd_pd (ref_i[j], const_2, d_imag[j]);
+				__m256d next_real = _mm256_fmsub_pd (sum_real, d_real[j], _mm256_fmsub_pd (sum_imag, d_imag[j], dc_real[j]));
+				d_imag[j] = _mm256_fmadd_pd (sum_real, d_imag[j], _mm256_fmadd_pd (sum_imag, d_real[j], dc_imag[j]));
+				d_real[j] = next_real;
+
+				m[j] = _mm256_add_epi64 (m[j], step);
+				if (shared_m[j] != diverged) {
+					shared_m[j]++;
+					ref_r[j] = _mm256_set1_pd (ref_real[shared_m[j]]);
+					ref_i[j] = _mm256_set1_pd (ref_imag[shared_m[j]]);
+				}
+				else {
+					ref_r[j] = _mm256_i64gather_pd (ref_real, m[j], 8);
+					ref_i[j] = _mm256_i64gather_pd (ref_imag, m[j], 8);
+				}
+				__m256d z_real = _mm256_add_pd (ref_r[j], d_real[j]);
+				__m256d z_imag = _mm256_add_pd (ref_i[j], d_imag[j]);
+
+				__m256d mag = _mm256_fmadd_pd (z_real, z_real, _mm256_mul_pd (z_imag, z_imag));
+				if constexpr (smooth)
+					escaped[j] = _mm256_max_pd (escaped[j], _mm256_and_pd (mag, active[j]));
+				active[j] = _mm256_and_pd (active[j], _mm256_cmp_pd (mag, bound, _CMP_LE_OQ));
+				count[j] = _mm256_add_pd (count[j], _mm256_and_pd (active[j], one));
+
+				// rebase: z becomes the offset from Z_0 = 0, lanes which are done
+				// only at the end of the reference, so they keep sharing the index
+				__m256d d_mag = _mm256_fmadd_pd (d_real[j], d_real[j], _mm256_mul_pd (d_imag[j], d_imag[j]));
+				__m256d rebase = _mm256_or_pd (
+					_mm256_and_pd (_mm256_cmp_pd (mag, d_mag, _CMP_LT_OQ), active[j]),
+					_mm256_castsi256_pd (_mm256_cmpeq_epi64 (m[j], last))
+				);
+				int rebased = _mm256_movemask_pd (rebase);
+				if (rebased) {
+					d_real[j] = _mm256_blendv_pd (d_real[j], z_real, rebase);
+					d_imag[j] = _mm256_blendv_pd (d_imag[j], z_imag, rebase);
+					ref_r[j] = _mm256_andnot_pd (rebase, ref_r[j]);
+					ref_i[j] = _mm256_andnot_pd (rebase, ref_i[j]);
+					m[j] = _mm256_andnot_si256 (_mm256_castpd_si256 (rebase), m[j]);
+					shared_m[j] = rebased == 0xf ? 0 : diverged;
+				}
+
+				if (_mm256_movemask_pd (active[j]) == 0)
+					block_active &= ~(1u << j);
+			}
+		}
+
+		return double_results<size, smooth> (count, escaped);
+	}
+
+	/** Offsets after the iterations of the series, u (a + u (b + u c)) with u = dc / radius */
+	void series_delta (__m256d dc_real, __m256d dc_imag, __m256d& d_real, __m256d& d_imag) const {
+		__m256d inverse = _mm256_set1_pd (1 / _series.radius);
+		__m256d u_real = _mm256_mul_pd (dc_real, inverse);
+		__m256d u_imag = _mm256_mul_pd (dc_imag, inverse);
+		d_real = _mm256_set1_pd (_series.c.real ());
+		d_imag = _mm256_set1_pd (_series.c.imag ());
+		for (const complex_d_t& coefficient : { _series.b, _series.a, complex_d_t{} })
+		{
+			__m256d next_real = _mm256_fmsub_pd (u_real, d_real, _mm256_fmsub_pd (u_imag, d_imag, _mm256_set1_pd (coefficient.real ())));
+			d_imag = _mm256_fmadd_pd (u_real, d_imag, _mm256_fmadd_pd (u_imag, d_real, _mm256_set1_pd (coefficient.imag ())));
+			d_real = next_real;
+		}
+	}
+
+	/** 4 double-double numbers hi + lo, see dd_real */
+	struct dd_vector_t
+	{
+		__m256d hi;
+		__m256d lo;
+	};
+
+	static dd_vector_t dd_two_sum (__m256d a, __m256d b) {
+		__m256d sum = _mm256_add_pd (a, b);
+		__m256d b_virtual = _mm256_sub_pd (sum, a);
+		__m256d error = _mm256_add_pd (
+			_mm256_sub_pd (a, _mm256_sub_pd (sum, b_virtual)),
+			_mm256_sub_pd (b, b_virtual));
+		return { sum, error };
+	}
+
+	static dd_vector_t dd_quick_two_sum (__m256d a, __m256d b) {
+		__m256d sum = _mm256_add_pd (a, b);
+		return { sum, _mm256_sub_pd (b, _mm256_sub_pd (sum, a)) };
+	}
+
+	/**
+	Sum with one two_sum instead of the two of dd_real. Its error stays below
+	~2^-104 of the larger operand instead of the sum, which is still far below
+	the pixels at the depths double-double resolves.
+	*/
+	static dd_vector_t dd_add (dd_vector_t a, dd_vector_t b) {
+		dd_vector_t sum = dd_two_sum (a.hi, b.hi);
+		return dd_quick_two_sum (sum.hi, _mm256_add_pd (sum.lo, _mm256_add_pd (a.lo, b.lo)));
+	}
+
+	/** The FMA yields the rounding error of hi * hi exactly (two_prod) */
+	static dd_vector_t dd_mul (dd_vector_t a, dd_vector_t b) {
+		__m256d product = _mm256_mul_pd (a.hi, b.hi);
+		__m256d error = _mm256_fmsub_pd (a.hi, b.hi, product);
+		error = _mm256_fmadd_pd (a.hi, b.lo, _mm256_fmadd_pd (a.lo, b.hi, error));
+		return dd_quick_two_sum (product, error);
+	}
+
+	/**
+	4 offsets from _center per vector in double-double, see
+	mandelbrot_double_double and mandelbrot_avx_double. The escape test only
+	needs the hi parts. There is no periodicity check, FRACTAL_PERIOD_EPSILON
+	is far larger than the pixels of these frames.
+	*/
+	template<int size = 1, bool smooth = false>
+	std::array<size_t, size * 4> mandelbrot_avx_double_double (std::array<__m256d, size> dc_real, std::array<__m256d, size> dc_imag, std::array<__m256d, size> interior) {
+		const __m256d bound = _mm256_set1_pd (FRACTAL_BOUND);
+		const __m256d one = _mm256_set1_pd (1);
+		const __m256d max_count = _mm256_set1_pd ((double)iterations () - 1);
+		const __m256d sign = _mm256_set1_pd (-0.0);
+		const dd_vector_t center_real{ _mm256_set1_pd (_exact_center.real.hi), _mm256_set1_pd (_exact_center.real.lo) };
+		const dd_vector_t center_imag{ _mm256_set1_pd (_exact_center.imag.hi), _mm256_set1_pd (_exact_center.imag.lo) };
+
+		std::array<dd_vector_t, size> c_real;
+		std::array<dd_vector_t, size> c_imag;
+		std::array<dd_vector_t, size> z_real;
+		std::array<dd_vector_t, size> z_imag;
+		std::array<__m256d, size> escaped;
+		escaped.fill (bound);
+
+		std::array<__m256d, size> active;
+		std::array<__m256d, size> count;
+		unsigned int block_active = 0;
+		for (size_t j = 0; j < size; j++)
+		{
+			// the center with its digits past double
+			c_real[j] = dd_add (center_real, { dc_real[j], _mm256_setzero_pd () });
+			c_imag[j] = dd_add (center_imag, { dc_imag[j], _mm256_setzero_pd () });
+			z_real[j] = { _mm256_setzero_pd (), _mm256_setzero_pd () };
+			z_imag[j] = z_real[j];
+			active[j] = _mm256_andnot_pd (interior[j], _mm256_castsi256_pd (_mm256_set1_epi64x (-1)));
+			count[j] = _mm256_and_pd (interior[j], max_count);
+			if (_mm256_movemask_pd (active[j]))
+				block_active |= 1u << j;
+		}
+		for (size_t i = 0; i < iterations () && block_active; i++)
+		{
+			for (size_t j = 0; j < size; j++)
+			{
+				if (!(block_active & (1u << j)))
+					continue;
+
+				dd_vector_t real_sq = dd_mul (z_real[j], z_real[j]);
+				dd_vector_t imag_sq = dd_mul (z_imag[j], z_imag[j]);
+				dd_vector_t prod = dd_mul (z_real[j], z_imag[j]);
+				dd_vector_t minus_imag_sq{ _mm256_xor_pd (imag_sq.hi, sign), _mm256_xor_pd (imag_sq.lo, sign) };
+				z_real[j] = dd_add (dd_add (real_sq, minus_imag_sq), c_real[j]);
+				// doubling is exact in both parts
+				dd_vector_t prod_2{ _mm256_add_pd (prod.hi, prod.hi), _mm256_add_pd (prod.lo, prod.lo) };
+				z_imag[j] = dd_add (prod_2, c_imag[j]);
+
+				__m256d mag = _mm256_fmadd_pd (z_real[j].hi, z_real[j].hi, _mm256_mul_pd (z_imag[j].hi, z_imag[j].hi));
+				if constexpr (smooth)
+					escaped[j] = _mm256_max_pd (escaped[j], _mm256_and_pd (mag, active[j]));
+				active[j] = _mm256_and_pd (active[j], _mm256_cmp_pd (mag, bound, _CMP_LE_OQ));
+				count[j] = _mm256_add_pd (count[j], _mm256_and_pd (active[j], one));
+
+				if (_mm256_movemask_pd (active[j]) == 0)
+					block_active &= ~(1u << j);
+			}
+		}
+
+		return double_results<size, smooth> (count, escaped);
+	}
+
+	/** Absolute points with mandelbrot_avx_double, offsets from _center with the others */
+	template<int size, Precision precision>
+	std::array<size_t, size * 4> iterate_double (const std::array<__m256d, size>& c_real, const std::array<__m256d, size>& c_imag, const std::array<__m256d, size>& interior) {
+		if constexpr (precision == Precision::Perturbation)
+			return _smooth
+				? mandelbrot_avx_perturbation<size, true> (c_real, c_imag, interior)
+				: mandelbrot_avx_perturbation<size, false> (c_real, c_imag, interior);
+		else if constexpr (precision == Precision::DoubleDouble)
+			return _smooth
+				? mandelbrot_avx_double_double<size, true> (c_real, c_imag, interior)
+				: mandelbrot_avx_double_double<size, false> (c_real, c_imag, interior);
+		else
+			return _smooth
+				? mandelbrot_avx_double<size, true> (c_real, c_imag, interior)
+				: mandelbrot_avx_double<size, false> (c_real, c_imag, interior);
+	}
+
+	/** Results of the double kernels from their counters and the |z|^2 the lanes escaped with */
+	template<int size, bool smooth>
+	std::array<size_t, size * 4> double_results (const std::array<__m256d, size>& count, const std::array<__m256d, size>& escaped) {
+		const __m256d max_count = _mm256_set1_pd ((double)iterations () - 1);
+		// 4 lanes are too few to pay for the vectorized entries of the float kernels
+		std::array<size_t, size * 4> result;
+		for (size_t j = 0; j < size; j++)
+		{
+			alignas(32) std::array<double, 4> counts;
+			alignas(32) std::array<double, 4> mags;
+			_mm256_store_pd (counts.data (), _mm256_min_pd (count[j], max_count));
+			_mm256_store_pd (mags.data (), escaped[j]);
+			for (size_t k = 0; k < 4; k++)
+			{
+				size_t lane_count = (size_t)counts[k];
+				// see store_entries, the count can not tell bounded lanes from the ones escaping in the last iteration
+				if constexpr (smooth)
+					result[j * 4 + k] = mags[k] <= FRACTAL_BOUND
+						? bounded_result ()
+						: smooth_entry (lane_count, (float)std::log2 (mags[k]) / log2_bound);
+				else
+					result[j * 4 + k] = lane_count;
+			}
+		}
+		return result;
+	}
+
+	size_t julia (complex_t z) {
+		complex_t c{ -0.8f, 0.156f };
+		for (size_t i = 0; i < iterations (); i++)
+		{
+			z = z * z + c;
+			auto mag = std::norm (z);
+			if (mag > FRACTAL_BOUND) { // divereged - not in set
+				return i;
+			}
+		}
+		// bounded - in set
+		return iterations () - 1;
+	}
+};
+
+/**
+Common iteration budgets get kernels with a constant trip count, all others
+use the kernel reading the budget at runtime. Calls fn with the budget as an
+std::integral_constant, 0 stands for the runtime budget.
+*/
+template<typename Fn>
+size_t dispatch_iterations (size_t iterations, Fn&& fn) {
+	switch (iterations)
+	{
+		case 128:
+			return fn (std::integral_constant<size_t, 128>{});
+		case 256:
+			return fn (std::integral_constant<size_t, 256>{});
+		case 512:
+			return fn (std::integral_constant<size_t, 512>{});
+		case 1024:
+			return fn (std::integral_constant<size_t, 1024>{});
+		case 2048:
+			return fn (std::integral_constant<size_t, 2048>{});
+		case 4096:
+			return fn (std::integral_constant<size_t, 4096>{});
+		default:
+			return fn (std::integral_constant<size_t, 0>{});
+	}
+}
+
+/**
+Every fixed budget is another copy of a kernel, so only the common case gets
+them: colors from the color map of frames iterated in float. Palette indices,
+counts, smooth coloring and the deeper precisions take the runtime budget.
+*/
+inline bool uses_fixed_iterations (const FractalZooming& zooming, const std::array<double, 2>& scale) {
+	return zooming.coloring == FractalZooming::Coloring::Iterations
+		&& zooming.frame_precision (scale) == FractalZooming::Precision::Float;
+}
+
+template<FracUseCPUExt cpu_ext, int pixels_size, typename pixel_type>
+size_t fill_row_iterations (size_t y_begin, size_t y_end, int x_begin, int x_end, pixel_type* image, const FractalZooming& zooming, const complex_d_t& lower_left, const std::array<double, 2>& scale, size_t iterations, const series_t& series, int image_width, int image_height) {
+	if constexpr (std::is_same_v<pixel_type, pixel_t>) {
+		if (uses_fixed_iterations (zooming, scale))
+			return dispatch_iterations (iterations, [&](auto fixed_iterations) {
+				return FracKernel<cpu_ext, pixels_size, decltype (fixed_iterations)::value, pixel_type>::fill_rows (y_begin, y_end, x_begin, x_end, image, zooming, lower_left, scale, iterations, series, image_width, image_height);
+			});
+	}
+	return FracKernel<cpu_ext, pixels_size, 0, pixel_type>::fill_rows (y_begin, y_end, x_begin, x_end, image, zooming, lower_left, scale, iterations, series, image_width, image_height);
+}
+
+template<FracUseCPUExt cpu_ext, int pixels_size, typename pixel_type>
+size_t fill_points_iterations (const std::vector<size_t>& points, std::vector<pixel_type>& image, const FractalZooming& zooming, const complex_d_t& lower_left, const std::array<double, 2>& scale, size_t iterations, const series_t& series, int image_width, int image_height) {
+	if constexpr (std::is_same_v<pixel_type, pixel_t>) {
+		if (uses_fixed_iterations (zooming, scale))
+			return dispatch_iterations (iterations, [&](auto fixed_iterations) {
+				return FracKernel<cpu_ext, pixels_size, decltype (fixed_iterations)::value, pixel_type>::fill_points (points, image.data (), zooming, lower_left, scale, iterations, series, image_width, image_height);
+			});
+	}
+	return FracKernel<cpu_ext, pixels_size, 0, pixel_type>::fill_points (points, image.data (), zooming, lower_left, scale, iterations, series, image_width, image_height);
+}
+
+/** Maps the runtime pixels_size onto the instantiated kernels */
+template<FracUseCPUExt cpu_ext, typename pixel_type = pixel_t>
+fill_rows_fn<pixel_type> select_fill_row (int pixels_size) {
+	switch (pixels_size)
+	{
+		case 1:
+			return &fill_row_iterations<cpu_ext, 1, pixel_type>;
+		case 2:
+			return &fill_row_iterations<cpu_ext, 2, pixel_type>;
+		case 4:
+			return &fill_row_iterations<cpu_ext, 4, pixel_type>;
+		case 8:
+			return &fill_row_iterations<cpu_ext, 8, pixel_type>;
+		default:
+			throw std::invalid_argument ("pixels_size must be 1, 2, 4 or 8 (is " + std::to_string (pixels_size) + ")");
+	}
+}
+
+template<FracUseCPUExt cpu_ext, typename pixel_type = pixel_t>
+fill_point_list_fn<pixel_type> select_fill_points (int pixels_size) {
+	switch (pixels_size)
+	{
+		case 1:
+			return &fill_points_iterations<cpu_ext, 1, pixel_type>;
+		case 2:
+			return &fill_points_iterations<cpu_ext, 2, pixel_type>;
+		case 4:
+			return &fill_points_iterations<cpu_ext, 4, pixel_type>;
+		case 8:
+			return &fill_points_iterations<cpu_ext, 8, pixel_type>;
+		default:
+			throw std::invalid_argument ("pixels_size must be 1, 2, 4 or 8 (is " + std::to_string (pixels_size) + ")");
+	}
+}
+
+/**
+Coloring pass of frames of iteration counts: a table lookup per pixel, which
+AVX2 and AVX-512 do for a whole vector with one gather. AVX without AVX2 has
+no integer gather and colors pixel by pixel.
+*/
+template<FracUseCPUExt cpu_ext>
+void color_frame (const iteration_count_t* counts, size_t pixel_count, const pixel_t* color_map, pixel_t* image) {
+	static_assert (sizeof (pixel_t) == sizeof (int), "a color is gathered as an int");
+	const int* colors = reinterpret_cast<const int*> (color_map);
+	size_t i = 0;
+	if constexpr (cpu_ext == FracUseCPUExt::AVX512) {
+		for (; i + 16 <= pixel_count; i += 16)
+		{
+			__m512i index = _mm512_cvtepu16_epi32 (_mm256_loadu_si256 ((const __m256i*)(counts + i)));
+			_mm512_storeu_si512 ((void*)(image + i), _mm512_i32gather_epi32 (index, colors, 4));
+		}
+	}
+	else if constexpr (cpu_ext == FracUseCPUExt::AVX_FMA) {
+		for (; i + 8 <= pixel_count; i += 8)
+		{
+			__m256i index = _mm256_cvtepu16_epi32 (_mm_loadu_si128 ((const __m128i*)(counts + i)));
+			_mm256_storeu_si256 ((__m256i*)(image + i), _mm256_i32gather_epi32 (colors, index, 4));
+		}
+	}
+	for (; i < pixel_count; i++)
+	{
+		image[i] = color_map[counts[i]];
+	}
+}
+
+}
@@ -0,0 +1,32 @@
+#include "frac_kernel.h"
+#include "frac_kernel_impl.h"
+
+template<>
+fill_row_fn frac_fill_row<FracUseCPUExt::None> (int pixels_size) {
+	return select_fill_row<FracUseCPUExt::None> (pixels_size);
+}
+
+template<>
+fill_index_row_fn frac_fill_index_row<FracUseCPUExt::None> (int pixels_size) {
+	return select_fill_row<FracUseCPUExt::None, palette_index_t> (pixels_size);
+}
+
+template<>
+fill_count_row_fn frac_fill_count_row<FracUseCPUExt::None> (int pixels_size) {
+	return select_fill_row<FracUseCPUExt::None, iteration_count_t> (pixels_size);
+}
+
+template<>
+fill_points_fn frac_fill_points<FracUseCPUExt::None> (int pixels_size) {
+	return select_fill_points<FracUseCPUExt::None> (pixels_size);
+}
+
+template<>
+fill_count_points_fn frac_fill_count_points<FracUseCPUExt::None> (int pixels_size) {
+	return select_fill_points<FracUseCPUExt::None, iteration_count_t> (pixels_size);
+}
+
+template<>
+color_frame_fn frac_color_frame<FracUseCPUExt::None> () {
+	return &color_frame<FracUseCPUExt::None>;
+}
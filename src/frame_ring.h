@@ -0,0 +1,88 @@
+#pragma once
+
+#include <vector>
+#include <optional>
+#include <mutex>
+#include <condition_variable>
+
+#include "types.h"
+
+/**
+Ring of reusable frame buffers between one producer (the renderer) and the
+consumers (the encoders). The producer blocks in acquire while every buffer still
+waits for a consumer, so a slow encoder holds back the rendering instead of
+frames piling up in memory. Consumers take the frames in order and must release
+them in the same order.
+*/
+template<typename pixel_type = pixel_t>
+class FrameRing {
+	std::vector<std::vector<pixel_type>> _frames;
+	/** Frames published by the producer, taken and released by the consumers so far */
+	size_t _published = 0;
+	size_t _taken = 0;
+	size_t _released = 0;
+	bool _closed = false;
+	std::mutex _mutex;
+	std::condition_variable _changed;
+
+public:
+	FrameRing (size_t frame_count, size_t frame_size)
+		: _frames(frame_count, std::vector<pixel_type>(frame_size)) { }
+
+	FrameRing (const FrameRing&) = delete;
+	FrameRing& operator= (const FrameRing&) = delete;
+
+	/** Buffer for the next frame, blocks while the ring is full */
+	std::vector<pixel_type>& acquire () {
+		std::unique_lock<std::mutex> lock (_mutex);
+		_changed.wait (lock, [this] { return _published - _released < _frames.size (); });
+		return _frames[_published % _frames.size ()];
+	}
+
+	/** Hands the acquired buffer over to the consumer */
+	void publish () {
+		{
+			std::lock_guard<std::mutex> lock (_mutex);
+			_published++;
+		}
+		_changed.notify_all ();
+	}
+
+	/** No frames are published anymore, the consumer drains the ring and stops */
+	void close () {
+		{
+			std::lock_guard<std::mutex> lock (_mutex);
+			_closed = true;
+		}
+		_changed.notify_all ();
+	}
+
+	/** Index of the oldest published frame no consumer took yet, nullopt once the ring is closed and drained */
+	std::optional<size_t> next () {
+		std::unique_lock<std::mutex> lock (_mutex);
+		_changed.wait (lock, [this] { return _taken < _published || _closed; });
+		if (_taken == _published)
+			return std::nullopt;
+		return _taken++;
+	}
+
+	/** Buffer of a frame taken with next, valid until it is released */
+	const std::vector<pixel_type>& frame (size_t index) const {
+		return _frames[index % _frames.size ()];
+	}
+
+	/** Blocks until the frames before index are released, so consumers can write their frames in order */
+	void wait_for_turn (size_t index) {
+		std::unique_lock<std::mutex> lock (_mutex);
+		_changed.wait (lock, [this, index] { return _released == index; });
+	}
+
+	/** Returns the oldest taken buffer to the producer */
+	void release () {
+		{
+			std::lock_guard<std::mutex> lock (_mutex);
+			_released++;
+		}
+		_changed.notify_all ();
+	}
+};
@@ -0,0 +1,191 @@
+#pragma once
+
+#include <cstdio>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <array>
+#include <memory>
+#include <algorithm>
+#include <stdexcept>
+
+#ifdef _WIN32
+#include <io.h>
+#include <fcntl.h>
+#endif
+
+#include "types.h"
+
+/**
+Receives the rendered frames besides the gif, e.g. to stream them into an
+external video encoder. Frames arrive in order and one call at a time.
+*/
+class FrameSink {
+	std::vector<pixel_t> _colored;
+
+public:
+	virtual ~FrameSink () = default;
+
+	virtual void append_frame (const pixel_t* frame, size_t count) = 0;
+
+	/** Frames of palette indices are colored with the palette first */
+	virtual void append_frame (const palette_index_t* frame, size_t count, const std::vector<pixel_t>& palette) {
+		_colored.resize (count);
+		for (size_t i = 0; i < count; i++)
+		{
+			_colored[i] = palette[frame[i]];
+		}
+		append_frame (_colored.data (), count);
+	}
+
+	void append_frame (const std::vector<pixel_t>& frame) {
+		append_frame (frame.data (), frame.size ());
+	}
+
+	void append_frame (const std::vector<palette_index_t>& frame, const std::vector<pixel_t>& palette) {
+		append_frame (frame.data (), frame.size (), palette);
+	}
+};
+
+/**
+Writes to a file or, for "-", to stdout. Every frame is handed to a single
+fwrite, which passes a buffer of this size straight to the OS instead of
+copying it through the stdio buffer.
+*/
+class StreamSink : public FrameSink {
+	std::FILE* _file;
+	bool _close;
+
+protected:
+	StreamSink (const std::string& target)
+		: _file{ target == "-" ? stdout : std::fopen (target.c_str (), "wb") }, _close{ target != "-" } {
+		if (!_file)
+			throw std::runtime_error ("cannot open " + target);
+#ifdef _WIN32
+		if (!_close)
+			_setmode (_fileno (stdout), _O_BINARY);
+#endif
+	}
+
+	void write (const void* data, size_t size) {
+		if (std::fwrite (data, 1, size, _file) != size)
+			throw std::runtime_error ("writing a frame failed, was the pipe closed?");
+	}
+
+public:
+	StreamSink (const StreamSink&) = delete;
+	StreamSink& operator= (const StreamSink&) = delete;
+
+	~StreamSink () {
+		if (_close)
+			std::fclose (_file);
+		else
+			std::fflush (_file);
+	}
+};
+
+/** Frames as they are in memory, 4 bytes (RGBA) per pixel, e.g. for ffmpeg -f rawvideo -pix_fmt rgba */
+class RawRGBASink : public StreamSink {
+public:
+	RawRGBASink (const std::string& target)
+		: StreamSink (target) { }
+
+	using FrameSink::append_frame;
+
+	void append_frame (const pixel_t* frame, size_t count) override {
+		write (frame, count * sizeof (pixel_t));
+	}
+};
+
+/**
+YUV4MPEG2 stream, 4:2:0 full range (BT.601 as in JPEG), which video encoders
+read without being told the size or the frame rate.
+*/
+class Y4MSink : public StreamSink {
+	int _width;
+	int _height;
+	int _chroma_width;
+	int _chroma_height;
+	/** "FRAME\n" and the Y, U and V planes, written with one call */
+	std::vector<unsigned char> _frame;
+	/** Y, U and V of the palette entries, a frame of indices needs no arithmetic per pixel */
+	std::array<std::array<int, 3>, 256> _palette_yuv;
+
+	static constexpr std::string_view frame_header = "FRAME\n";
+
+public:
+	Y4MSink (const std::string& target, int width, int height, int frames_per_second)
+		: StreamSink (target), _width{ width }, _height{ height },
+		_chroma_width{ (width + 1) / 2 }, _chroma_height{ (height + 1) / 2 } {
+		std::string header = "YUV4MPEG2 W" + std::to_string (width) + " H" + std::to_string (height)
+			+ " F" + std::to_string (frames_per_second) + ":1 Ip A1:1 C420jpeg XCOLORRANGE=FULL\n";
+		write (header.data (), header.size ());
+
+		_frame.resize (frame_header.size () + (size_t)width * height + 2 * (size_t)_chroma_width * _chroma_height);
+		std::copy (std::begin (frame_header), std::end (frame_header), std::begin (_frame));
+	}
+
+	using FrameSink::append_frame;
+
+	void append_frame (const pixel_t* frame, size_t count) override {
+		convert (frame, [](const pixel_t& pixel) { return to_yuv (pixel); });
+	}
+
+	void append_frame (const palette_index_t* frame, size_t count, const std::vector<pixel_t>& palette) override {
+		for (size_t i = 0; i < palette.size () && i < _palette_yuv.size (); i++)
+		{
+			_palette_yuv[i] = to_yuv (palette[i]);
+		}
+		convert (frame, [this](palette_index_t index) { return _palette_yuv[index]; });
+	}
+
+private:
+	/** Fixed point BT.601 with 16 fractional bits */
+	static std::array<int, 3> to_yuv (const pixel_t& pixel) {
+		int r = pixel.r, g = pixel.g, b = pixel.b;
+		return {
+			(19595 * r + 38470 * g + 7471 * b + 32768) >> 16,
+			((-11059 * r - 21709 * g + 32768 * b + 32768) >> 16) + 128,
+			((32768 * r - 27439 * g - 5329 * b + 32768) >> 16) + 128
+		};
+	}
+
+	/** Chroma is the average of 2x2 pixels, clamped to the image at odd sizes */
+	template<typename pixel_type, typename ToYUV>
+	void convert (const pixel_type* frame, ToYUV&& to_yuv) {
+		unsigned char* y_plane = _frame.data () + frame_header.size ();
+		unsigned char* u_plane = y_plane + (size_t)_width * _height;
+		unsigned char* v_plane = u_plane + (size_t)_chroma_width * _chroma_height;
+		for (int cy = 0; cy < _chroma_height; cy++)
+		{
+			int y0 = 2 * cy, y1 = std::min (2 * cy + 1, _height - 1);
+			for (int cx = 0; cx < _chroma_width; cx++)
+			{
+				int x0 = 2 * cx, x1 = std::min (2 * cx + 1, _width - 1);
+				auto a = to_yuv (frame[(size_t)y0 * _width + x0]);
+				auto b = to_yuv (frame[(size_t)y0 * _width + x1]);
+				auto c = to_yuv (frame[(size_t)y1 * _width + x0]);
+				auto d = to_yuv (frame[(size_t)y1 * _width + x1]);
+				y_plane[(size_t)y0 * _width + x0] = (unsigned char)a[0];
+				y_plane[(size_t)y0 * _width + x1] = (unsigned char)b[0];
+				y_plane[(size_t)y1 * _width + x0] = (unsigned char)c[0];
+				y_plane[(size_t)y1 * _width + x1] = (unsigned char)d[0];
+				u_plane[(size_t)cy * _chroma_width + cx] = (unsigned char)((a[1] + b[1] + c[1] + d[1] + 2) >> 2);
+				v_plane[(size_t)cy * _chroma_width + cx] = (unsigned char)((a[2] + b[2] + c[2] + d[2] + 2) >> 2);
+			}
+		}
+		write (_frame.data (), _frame.size ());
+	}
+};
+
+/**
+Sink for target (a file, "-" for stdout) in the given format: "y4m" or
+"rgba" (raw RGBA frames).
+*/
+inline std::shared_ptr<FrameSink> open_frame_sink (const std::string& target, std::string_view format, int width, int height, int frames_per_second) {
+	if (format == "y4m")
+		return std::make_shared<Y4MSink> (target, width, height, frames_per_second);
+	if (format == "rgba")
+		return std::make_shared<RawRGBASink> (target);
+	throw std::invalid_argument ("unknown video format " + std::string (format) + ", use y4m or rgba");
+}
@@ -0,0 +1,236 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <algorithm>
+#include <stdexcept>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#include "types.h"
+
+/**
+Frames of a zoom in a file which is mapped into memory, a fixed header and the
+frames one after another. The renderers write into the mapping directly and
+release the frames once they are done with them, the OS writes the pages back
+to the file on its own. So a long sequence at a high resolution needs no more
+memory than the frames being rendered, and the file can be opened again to
+encode the frames later without rendering them again.
+*/
+template<typename pixel_type = pixel_t>
+class FrameStore {
+public:
+	struct header_t {
+		char magic[8];
+		std::uint32_t version;
+		/** sizeof (pixel_type) of the frames */
+		std::uint32_t pixel_size;
+		std::uint32_t width;
+		std::uint32_t height;
+		std::uint64_t frame_count;
+		/** Frames released so far, less than frame_count if the rendering was interrupted */
+		std::uint64_t frames_done;
+	};
+
+	/** The frames start at a page boundary */
+	static constexpr size_t header_size = 4096;
+	static constexpr char magic[8] = { 'F', 'R', 'A', 'C', 'Z', 'O', 'O', 'M' };
+	static constexpr std::uint32_t version = 1;
+
+private:
+	std::string _file_name;
+	header_t* _header = nullptr;
+	unsigned char* _data = nullptr;
+	size_t _size = 0;
+	size_t _frame_size = 0;
+	bool _writable;
+#ifdef _WIN32
+	HANDLE _file = INVALID_HANDLE_VALUE;
+	HANDLE _mapping = nullptr;
+#else
+	int _file = -1;
+#endif
+
+public:
+	/** Creates (or replaces) file_name with room for frame_count frames */
+	FrameStore (const std::string& file_name, int width, int height, size_t frame_count)
+		: _file_name{ file_name }, _writable{ true } {
+		if (width <= 0 || height <= 0)
+			throw std::invalid_argument ("frame store needs a size > 0 (is " + std::to_string (width) + " x " + std::to_string (height) + ")");
+		_frame_size = (size_t)width * height * sizeof (pixel_type);
+		map (header_size + _frame_size * frame_count);
+
+		header_t header{};
+		std::copy (std::begin (magic), std::end (magic), header.magic);
+		header.version = version;
+		header.pixel_size = sizeof (pixel_type);
+		header.width = width;
+		header.height = height;
+		header.frame_count = frame_count;
+		*_header = header;
+	}
+
+	/** Opens the frames stored in file_name before, read only */
+	explicit FrameStore (const std::string& file_name)
+		: _file_name{ file_name }, _writable{ false } {
+		map (0);
+		if (_size < header_size
+			|| !std::equal (std::begin (magic), std::end (magic), _header->magic)
+			|| _header->version != version
+			|| _header->pixel_size != sizeof (pixel_type)) {
+			unmap ();
+			throw std::runtime_error (file_name + " is no frame store of this version and pixel type");
+		}
+		_frame_size = (size_t)_header->width * _header->height * sizeof (pixel_type);
+		if (_size < header_size + _frame_size * _header->frame_count) {
+			unmap ();
+			throw std::runtime_error (file_name + " is shorter than its frames");
+		}
+	}
+
+	FrameStore (const FrameStore&) = delete;
+	FrameStore& operator= (const FrameStore&) = delete;
+
+	~FrameStore () {
+		unmap ();
+	}
+
+	int width () const {
+		return _header->width;
+	}
+
+	int height () const {
+		return _header->height;
+	}
+
+	size_t frame_count () const {
+		return _header->frame_count;
+	}
+
+	size_t frames_done () const {
+		return _header->frames_done;
+	}
+
+	/** Pixels of frame index, width () * height () of them */
+	pixel_type* frame (size_t index) {
+		return reinterpret_cast<pixel_type*> (_data + header_size + _frame_size * index);
+	}
+
+	const pixel_type* frame (size_t index) const {
+		return reinterpret_cast<const pixel_type*> (_data + header_size + _frame_size * index);
+	}
+
+	/**
+	Drops the frames [first, first + count) from the memory of the process,
+	written frames go to the file first and count as done. The pages are read
+	again when a frame is accessed afterwards. A frame may share its first and
+	last page with its neighbors, they are dropped as well but stay intact.
+	*/
+	void release (size_t first, size_t count) {
+		size_t begin = header_size + _frame_size * first;
+		size_t end = std::min (header_size + _frame_size * (first + count), _size);
+		if (begin >= end)
+			return;
+		begin -= begin % page_size ();
+
+#ifdef _WIN32
+		if (_writable)
+			FlushViewOfFile (_data + begin, end - begin);
+		// unlocking pages which are not locked removes them from the working set
+		VirtualUnlock (_data + begin, end - begin);
+#else
+		if (_writable)
+			msync (_data + begin, end - begin, MS_ASYNC);
+		madvise (_data + begin, end - begin, MADV_DONTNEED);
+#endif
+
+		if (_writable)
+			_header->frames_done = std::max<std::uint64_t> (_header->frames_done, first + count);
+	}
+
+private:
+	static size_t page_size () {
+#ifdef _WIN32
+		SYSTEM_INFO info;
+		GetSystemInfo (&info);
+		return info.dwPageSize;
+#else
+		return (size_t)sysconf (_SC_PAGESIZE);
+#endif
+	}
+
+	/** Maps the file with the given size, 0 maps an existing file as it is */
+	void map (size_t size) {
+#ifdef _WIN32
+		_file = CreateFileA (_file_name.c_str (), _writable ? GENERIC_READ | GENERIC_WRITE : GENERIC_READ,
+			FILE_SHARE_READ, nullptr, _writable ? CREATE_ALWAYS : OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+		if (_file == INVALID_HANDLE_VALUE)
+			throw std::runtime_error ("cannot open " + _file_name);
+		LARGE_INTEGER file_size;
+		if (_writable) {
+			file_size.QuadPart = (LONGLONG)size;
+		}
+		else if (!GetFileSizeEx (_file, &file_size)) {
+			unmap ();
+			throw std::runtime_error ("cannot read the size of " + _file_name);
+		}
+		_size = (size_t)file_size.QuadPart;
+		// the mapping of a writable file grows it to its size
+		_mapping = _size == 0 ? nullptr : CreateFileMappingA (_file, nullptr, _writable ? PAGE_READWRITE : PAGE_READONLY,
+			file_size.HighPart, file_size.LowPart, nullptr);
+		_data = _mapping ? (unsigned char*)MapViewOfFile (_mapping, _writable ? FILE_MAP_WRITE : FILE_MAP_READ, 0, 0, _size) : nullptr;
+#else
+		_file = ::open (_file_name.c_str (), _writable ? O_RDWR | O_CREAT | O_TRUNC : O_RDONLY, 0644);
+		if (_file < 0)
+			throw std::runtime_error ("cannot open " + _file_name);
+		struct stat file_stat;
+		if (!_writable && fstat (_file, &file_stat) == 0) {
+			size = (size_t)file_stat.st_size;
+		}
+		// the frames are not written yet, the file is sparse until they are
+		else if (_writable && ftruncate (_file, (off_t)size) != 0) {
+			unmap ();
+			throw std::runtime_error ("cannot grow " + _file_name + " to " + std::to_string (size) + " bytes");
+		}
+		_size = size;
+		void* data = _size == 0 ? MAP_FAILED : mmap (nullptr, _size, _writable ? PROT_READ | PROT_WRITE : PROT_READ, MAP_SHARED, _file, 0);
+		_data = data == MAP_FAILED ? nullptr : (unsigned char*)data;
+#endif
+		if (!_data) {
+			unmap ();
+			throw std::runtime_error ("cannot map " + _file_name + " into memory");
+		}
+		_header = reinterpret_cast<header_t*> (_data);
+	}
+
+	void unmap () {
+#ifdef _WIN32
+		if (_data)
+			UnmapViewOfFile (_data);
+		if (_mapping)
+			CloseHandle (_mapping);
+		if (_file != INVALID_HANDLE_VALUE)
+			CloseHandle (_file);
+		_mapping = nullptr;
+		_file = INVALID_HANDLE_VALUE;
+#else
+		if (_data)
+			munmap (_data, _size);
+		if (_file >= 0)
+			::close (_file);
+		_file = -1;
+#endif
+		_data = nullptr;
+		_header = nullptr;
+	}
+};
@@ -5,9 +5,15 @@
 #include <bitset>
 #include <array>
 #include <string>
+#include <cstring>
+#if defined(_MSC_VER)
 #include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
 
 // From: https://docs.microsoft.com/en-us/cpp/intrinsics/cpuid-cpuidex?view=vs-2019
+// CPUID and XGETBV are wrapped so this also works with GCC and Clang
 class InstructionSet
 {
 	// forward declarations
@@ -63,6 +69,10 @@ public:
 
 	static bool PREFETCHWT1 (void) { return CPU_Rep.f_7_ECX_[0]; }
 
+	// the OS has to save the AVX (YMM) and AVX-512 (ZMM, opmask) registers on context switches
+	static bool OS_AVX (void) { return CPU_Rep.osAVX_; }
+	static bool OS_AVX512 (void) { return CPU_Rep.osAVX512_; }
+
 	static bool LAHF (void) { return CPU_Rep.f_81_ECX_[0]; }
 	static bool LZCNT (void) { return CPU_Rep.isIntel_ && CPU_Rep.f_81_ECX_[5]; }
 	static bool ABM (void) { return CPU_Rep.isAMD_ && CPU_Rep.f_81_ECX_[5]; }
@@ -87,6 +97,8 @@ private:
 			nExIds_{ 0 },
 			isIntel_{ false },
 			isAMD_{ false },
+			osAVX_{ false },
+			osAVX512_{ false },
 			f_1_ECX_{ 0 },
 			f_1_EDX_{ 0 },
 			f_7_EBX_{ 0 },
@@ -101,12 +113,12 @@ private:
 
 			// Calling __cpuid with 0x0 as the function_id argument
 			// gets the number of the highest valid function ID.
-			__cpuid (cpui.data (), 0);
+			cpuid (cpui, 0, 0);
 			nIds_ = cpui[0];
 
 			for (int i = 0; i <= nIds_; ++i)
 			{
-				__cpuidex (cpui.data (), i, 0);
+				cpuid (cpui, i, 0);
 				data_.push_back (cpui);
 			}
 
@@ -140,9 +152,17 @@ private:
 				f_7_ECX_ = data_[7][2];
 			}
 
+			// XCR0 tells which register states are enabled by the OS
+			if (f_1_ECX_[27])
+			{
+				auto xcr0 = xgetbv (0);
+				osAVX_ = (xcr0 & 0x06) == 0x06; // SSE + AVX state
+				osAVX512_ = (xcr0 & 0xe6) == 0xe6; // additionally opmask + ZMM state
+			}
+
 			// Calling __cpuid with 0x80000000 as the function_id argument
 			// gets the number of the highest valid extended ID.
-			__cpuid (cpui.data (), 0x80000000);
+			cpuid (cpui, 0x80000000, 0);
 			nExIds_ = cpui[0];
 
 			char brand[0x40];
@@ -150,7 +170,7 @@ private:
 
 			for (int i = 0x80000000; i <= nExIds_; ++i)
 			{
-				__cpuidex (cpui.data (), i, 0);
+				cpuid (cpui, i, 0);
 				extdata_.push_back (cpui);
 			}
 
@@ -171,12 +191,34 @@ private:
 			}
 		};
 
+		static void cpuid (std::array<int, 4>& cpui, int function_id, int subfunction_id)
+		{
+#if defined(_MSC_VER)
+			__cpuidex (cpui.data (), function_id, subfunction_id);
+#else
+			__cpuid_count (function_id, subfunction_id, cpui[0], cpui[1], cpui[2], cpui[3]);
+#endif
+		}
+
+		static unsigned long long xgetbv (unsigned int xcr)
+		{
+#if defined(_MSC_VER)
+			return _xgetbv (xcr);
+#else
+			unsigned int eax, edx;
+			__asm__ volatile ("xgetbv" : "=a" (eax), "=d" (edx) : "c" (xcr));
+			return ((unsigned long long)edx << 32) | eax;
+#endif
+		}
+
 		int nIds_;
 		int nExIds_;
 		std::string vendor_;
 		std::string brand_;
 		bool isIntel_;
 		bool isAMD_;
+		bool osAVX_;
+		bool osAVX512_;
 		std::bitset<32> f_1_ECX_;
 		std::bitset<32> f_1_EDX_;
 		std::bitset<32> f_7_EBX_;
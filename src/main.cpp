@@ -2,6 +2,8 @@
 #include <sstream>
 #include <iomanip>
 #include <chrono>
+#include <functional>
+#include <numeric>
 
 #include "frac_cpu.h"
 
@@ -21,6 +23,23 @@ void execute_and_print_summary (FractalZooming& zooming, Frac& frac, TNext&... n
 			<< std::get<1> (e).count ()
 			<< "s" << std::endl;
 	}
+
+	const auto& skipped = frac.skipped_pixels ();
+	if (!skipped.empty ()) {
+		auto total = std::accumulate (std::begin (skipped), std::end (skipped), size_t{ 0 });
+		std::cout << " - skipped (not iterated): " << total << " pixels, "
+			<< std::setprecision (2) << std::fixed
+			<< 100.0 * total / skipped.size () / (frac.image_width () * frac.image_height ())
+			<< "% per frame, " << skipped.front () << " in the first frame"
+			<< std::endl;
+	}
+	const auto& series = frac.series_iterations ();
+	auto series_total = std::accumulate (std::begin (series), std::end (series), size_t{ 0 });
+	if (series_total != 0) {
+		std::cout << " - skipped by the series approximation: " << series_total << " iterations per pixel, "
+			<< series.back () << " in the last frame"
+			<< std::endl;
+	}
 	std::cout << "\n";
 
 	execute_and_print_summary (zooming, next...);
@@ -101,12 +120,26 @@ FractalZooming create_zooming () {
 		0.95f,
 		200,
 		complex_t{ -0.745289981f, 0.113075003f },
-		FractalZooming::SaveImage::No
+		FractalZooming::SaveImage::No,
+		FractalZooming::InteriorCheck::CardioidAndBulb,
+		FractalZooming::PeriodicityCheck::No, // only pays off with large iteration counts
+		FRACTAL_ITER,
+		0
 	};
-	for (size_t i = 0; i < COLOR_COUNT; i++)
+
+	// one color per iteration of the largest budget
+	size_t color_count = fractal_zoom.iterations;
+	if (fractal_zoom.iterations_doubling != 0)
+		color_count <<= (fractal_zoom.zoom_steps - 1) / fractal_zoom.iterations_doubling;
+	fractal_zoom.color_map.resize (color_count);
+	for (size_t i = 0; i < color_count; i++)
 	{
-		fractal_zoom.color_map[i] = interpolate (outside_col, inside_col, i * 1.0 / COLOR_COUNT);
+		fractal_zoom.color_map[i] = interpolate (outside_col, inside_col, i * 1.0 / color_count);
 	}
+	// smooth coloring goes around the hue circle, bounded points stay black
+	fractal_zoom.gradient = hsv_gradient (256, outside_col);
+	// frames past double resolution iterate relative to the orbit of the zoom center
+	fractal_zoom.compute_reference_orbit ();
 	std::cout << " Done!" << std::endl;
 	return fractal_zoom;
 }
@@ -120,21 +153,24 @@ void find_best () {
 	auto fractal_zoom = create_zooming ();
 	std::cout << std::endl;
 
-	auto best_glsp = find_optimal<FracCPU_GSLP<FracUseCPUExt::AVX_FMA, 4, FracProgress::None>> (fractal_zoom, [image_width, image_height](size_t t) {
-		return FracCPU_GSLP<FracUseCPUExt::AVX_FMA, 4, FracProgress::None> (image_width, image_height, t);
+	// the tiles are scheduled dynamically, one task per hardware thread keeps every core busy
+	const size_t tasks = std::thread::hardware_concurrency ();
+	auto best_glsp = find_optimal<FracCPU_GSLP<FracUseCPUExt::Auto, 4, FracProgress::None>> (fractal_zoom, [image_width, image_height, tasks](size_t tile_height) {
+		return FracCPU_GSLP<FracUseCPUExt::Auto, 4, FracProgress::None> (image_width, image_height, tasks, 64, (int)tile_height);
 		});
-	auto best_gpls = find_optimal<FracCPU_GPLS<FracUseCPUExt::AVX_FMA, 4, FracProgress::None>> (fractal_zoom, [image_width, image_height](size_t t) {
-		return FracCPU_GPLS<FracUseCPUExt::AVX_FMA, 4, FracProgress::None> (image_width, image_height, t);
+	auto best_gpls = find_optimal<FracCPU_GPLS<FracUseCPUExt::Auto, 4, FracProgress::None>> (fractal_zoom, [image_width, image_height](size_t t) {
+		return FracCPU_GPLS<FracUseCPUExt::Auto, 4, FracProgress::None> (image_width, image_height, t);
 		});
-	auto best_gplp = find_optimal<FracCPU_GPLP<FracUseCPUExt::AVX_FMA, 4, FracProgress::None>> (fractal_zoom, [image_width, image_height](size_t i, size_t t) {
-		return FracCPU_GPLP<FracUseCPUExt::AVX_FMA, 4, FracProgress::None> (image_width, image_height, i, t);
+	auto best_gplp = find_optimal<FracCPU_GPLP<FracUseCPUExt::Auto, 4, FracProgress::None>> (fractal_zoom, [image_width, image_height, tasks](size_t i) {
+		return FracCPU_GPLP<FracUseCPUExt::Auto, 4, FracProgress::None> (image_width, image_height, i, tasks);
 		});
 	std::cout << "Best:\n"
-		<< "GSLP: tasks = " << std::get<0> (best_glsp) << " with " << std::get<1> (best_glsp).count () << "s\n"
+		<< "GSLP: tile height = " << std::get<0> (best_glsp) << " with " << std::get<1> (best_glsp).count () << "s\n"
 		<< "GPLS: tasks = " << std::get<0> (best_gpls) << " with " << std::get<1> (best_gpls).count () << "s\n"
-		<< "GPLP: images = " << std::get<0> (best_gplp) << ", tasks = " << std::get<1> (best_gplp) << " with " << std::get<2> (best_gplp).count () << "s\n"
+		<< "GPLP: images = " << std::get<0> (best_gplp) << " with " << std::get<1> (best_gplp).count () << "s\n"
 		;
 	/*
+	Static row bands per task, before the tile scheduler:
 	Best: (1024 x 576 pixels)
 		GSLP: tasks = 32 with 1.41572s
 		GPLS: tasks = 64 with 1.43518s
@@ -146,7 +182,799 @@ void find_best () {
 	*/
 }
 
-void test_bed () {
+/**
+Single threaded throughput of the row kernels of every extension the host supports
+*/
+void bench_kernels () {
+	int image_width = 1024; int image_height = 576;
+	const size_t frames = 20;
+
+	std::cout << "Running               : bench_kernels" << std::endl;
+	std::cout << "Resolution            : " << image_width << " x " << image_height << " pixels" << std::endl;
+	std::cout << "Frames                : " << frames << "\n" << std::endl;
+
+	auto fractal_zoom = create_zooming ();
+	std::cout << std::endl;
+
+	std::vector<pixel_t> image (image_width * image_height);
+	const auto host_ext = detect_cpu_ext ();
+	for (auto cpu_ext : { FracUseCPUExt::None, FracUseCPUExt::AVX, FracUseCPUExt::AVX_FMA, FracUseCPUExt::AVX512 }) {
+		if (cpu_ext > host_ext)
+			break;
+
+		for (int pixels_size : { 1, 4 })
+		for (auto interior_check : { FractalZooming::InteriorCheck::No, FractalZooming::InteriorCheck::CardioidAndBulb })
+		for (auto coloring : { FractalZooming::Coloring::Iterations, FractalZooming::Coloring::Smooth }) {
+			if (cpu_ext == FracUseCPUExt::None && pixels_size > 1)
+				continue; // always computes pixel by pixel
+			if (coloring == FractalZooming::Coloring::Smooth && interior_check == FractalZooming::InteriorCheck::No)
+				continue;
+
+			fractal_zoom.interior_check = interior_check;
+			fractal_zoom.coloring = coloring;
+			auto fill_row = select_row_kernel (cpu_ext, pixels_size);
+
+			size_t skipped = 0;
+			Timer timer;
+			timer.start ("frames");
+			for (size_t i = 0; i < frames; i++)
+			{
+				auto [lower_left, upper_right] = fractal_zoom.frame_bounds (i);
+				auto scale = compute_scale (lower_left, upper_right, image_width, image_height);
+				auto series = fractal_zoom.frame_series (lower_left, upper_right, scale, fractal_zoom.frame_iterations (i));
+				for (size_t y = 0; y < image_height; y++)
+				{
+					skipped += fill_row (y, y + 1, 0, image_width, image.data (), fractal_zoom, lower_left, scale, fractal_zoom.frame_iterations (i), series, image_width, image_height);
+				}
+			}
+			timer.stop ();
+
+			std::cout << " - " << std::setw (8) << cpu_ext_name (cpu_ext)
+				<< " x" << pixels_size
+				<< (interior_check == FractalZooming::InteriorCheck::No ? "          " : " +interior")
+				<< (coloring == FractalZooming::Coloring::Smooth ? " +smooth" : "        ")
+				<< ": "
+				<< std::setprecision (2) << std::fixed
+				<< timer.total_in_ms () / frames << " ms/frame, "
+				<< (double)image_width * image_height * frames / timer.total_in_ms () / 1000 << " MPixel/s, "
+				<< skipped / frames << " pixels/frame skipped"
+				<< std::endl;
+		}
+	}
+	/*
+	"Intel(R) Xeon(R) Processor" with AVX-512, 1 hardware thread, GCC 12
+	Release build, ms/frame (1024 x 576 pixels). The kernels of a column are
+	only in the tree at the commit it names, check it out to repeat it.
+
+	6d5ef1c (scalar lane checks) against cf760fe (masks + counters in registers):
+		           scalar lane checks   masks + counters in registers
+		AVX2+FMA x1       34.80                20.70
+		AVX2+FMA x4       46.94                10.93
+		AVX512   x4           -                 6.51
+
+	Skipping the main cardioid and period-2 bulb (~230k of 590k pixels in the
+	first frames), 29b9556:
+		                  no check    +interior
+		AVX2+FMA x4          11.17         4.24
+		AVX512   x4           5.51         2.11
+
+	Smooth coloring, the lanes keep |z|^2 when they escape and the entries of
+	the gradient are computed once per vector after the loop, 853287f:
+		                 +interior    +smooth
+		AVX      x4           4.74       6.45
+		AVX2+FMA x4           4.05       5.23
+		AVX512   x4           2.48       2.86
+	*/
+}
+
+/** Time to run frames * tasks empty tasks, one group per frame as the renderers do */
+template<typename parallelizer>
+std::chrono::duration<double> time_empty_tasks (size_t frames, size_t tasks) {
+	auto start = std::chrono::steady_clock::now ();
+	for (size_t i = 0; i < frames; i++)
+	{
+		parallelizer group;
+		for (size_t t = 0; t < tasks; t++)
+		{
+			group.add ([](size_t) {}, t);
+		}
+		group.join_all ();
+	}
+	return std::chrono::steady_clock::now () - start;
+}
+
+/**
+Thread per task (thread_group, task_group) compared to the persistent pool (pool_group)
+*/
+void bench_parallelizers () {
+	int image_width = 1024; int image_height = 576;
+	const size_t tasks = 64;
+
+	std::cout << "Running               : bench_parallelizers" << std::endl;
+	std::cout << "Resolution            : " << image_width << " x " << image_height << " pixels" << std::endl;
+	std::cout << "Tasks                 : " << tasks << "\n" << std::endl;
+
+	auto fractal_zoom = create_zooming ();
+	std::cout << std::endl;
+
+	std::cout << "Overhead of " << fractal_zoom.zoom_steps << " x " << tasks << " empty tasks:" << std::endl;
+	std::cout << " - thread_group: " << time_empty_tasks<thread_group> (fractal_zoom.zoom_steps, tasks).count () << "s" << std::endl;
+	std::cout << " - task_group  : " << time_empty_tasks<task_group> (fractal_zoom.zoom_steps, tasks).count () << "s" << std::endl;
+	std::cout << " - pool_group  : " << time_empty_tasks<pool_group> (fractal_zoom.zoom_steps, tasks).count () << "s\n" << std::endl;
+
+	FracCPU_GSLP<FracUseCPUExt::Auto, 4, FracProgress::None, thread_group> frac_cpu_threads{ image_width, image_height, tasks };
+	FracCPU_GSLP<FracUseCPUExt::Auto, 4, FracProgress::None, task_group> frac_cpu_tasks{ image_width, image_height, tasks };
+	FracCPU_GSLP<FracUseCPUExt::Auto, 4, FracProgress::None, pool_group> frac_cpu_pool{ image_width, image_height, tasks };
+
+	execute_and_print_summary (fractal_zoom, frac_cpu_threads, frac_cpu_tasks, frac_cpu_pool);
+	compare_times (frac_cpu_threads, frac_cpu_tasks, frac_cpu_pool);
+	/*
+	Xeon with AVX-512 (1 hardware thread), 200 frames x 64 tasks:
+		              empty tasks   GSLP
+		thread_group     0.347s     1.80s
+		task_group       0.424s     2.00s
+		pool_group       0.004s     1.43s
+	*/
+}
+
+/**
+Mariani-Silver rendering compared to computing every pixel
+*/
+void bench_mariani_silver () {
+	int image_width = 1024; int image_height = 576;
+
+	std::cout << "Running               : bench_mariani_silver" << std::endl;
+	std::cout << "Resolution            : " << image_width << " x " << image_height << " pixels\n" << std::endl;
+
+	auto fractal_zoom = create_zooming ();
+	std::cout << std::endl;
+
+	const size_t tasks = std::thread::hardware_concurrency ();
+	FracCPU_GSLP<FracUseCPUExt::Auto, 4, FracProgress::None> frac_cpu_gslp{ image_width, image_height, tasks };
+	FracCPU_MS<FracUseCPUExt::Auto, 4, FracProgress::None> frac_cpu_ms{ image_width, image_height, tasks };
+
+	execute_and_print_summary (fractal_zoom, frac_cpu_gslp, frac_cpu_ms);
+	compare_times (frac_cpu_gslp, frac_cpu_ms);
+	/*
+	Xeon with AVX-512, 1 thread, speedup of MS over computing every pixel:
+		                 +interior   no interior check
+		128 iterations       1.02          1.46
+		1024 iterations      1.10             -
+	The interior check already skips the largest uniform area, MS mostly saves
+	the cheap pixels far outside the set. Differs in ~0.001% of the pixels.
+	*/
+}
+
+void bench_gif () {
+	const size_t frames = 8;
+
+	std::cout << "Running               : bench_gif" << std::endl;
+	std::cout << "Frames                : " << frames << "\n" << std::endl;
+
+	auto fractal_zoom = create_zooming ();
+	std::cout << std::endl;
+
+	auto fill_row = select_row_kernel (detect_cpu_ext (), 8);
+	auto fill_index_row = select_index_row_kernel (detect_cpu_ext (), 8);
+	auto delay = std::chrono::duration<short, std::centi>{ 3 };
+	for (auto [image_width, image_height] : { std::pair{ 1024, 576 }, std::pair{ 4096, 2304 } }) {
+		std::vector<pixel_t> image (image_width * image_height);
+		std::vector<palette_index_t> indices (image_width * image_height);
+		AnimatedGif gif ("bench_gif.gif", image_width, image_height);
+		AnimatedGif indexed_gif ("bench_gif_indexed.gif", image_width, image_height, fractal_zoom.palette ());
+		auto encoded = gif.encoded_frame ();
+
+		Timer timer;
+		Timer indexed_timer;
+		for (size_t i = 0; i < frames; i++)
+		{
+			// frames further into the zoom have more detail
+			auto [lower_left, upper_right] = fractal_zoom.frame_bounds (i * 20);
+			auto scale = compute_scale (lower_left, upper_right, image_width, image_height);
+			auto iterations = fractal_zoom.frame_iterations (i * 20);
+			auto series = fractal_zoom.frame_series (lower_left, upper_right, scale, iterations);
+			fill_row (0, image_height, 0, image_width, image.data (), fractal_zoom, lower_left, scale, iterations, series, image_width, image_height);
+			fill_index_row (0, image_height, 0, image_width, indices.data (), fractal_zoom, lower_left, scale, iterations, series, image_width, image_height);
+
+			timer.start ("encode");
+			gif.encode_frame (encoded, i, image.data (), image.size (), delay, true);
+			timer.stop ();
+			gif.write_frame (i, encoded);
+
+			indexed_timer.start ("encode");
+			indexed_gif.encode_frame (encoded, indices.data (), indices.size (), delay);
+			indexed_timer.stop ();
+			indexed_gif.write_frame (i, encoded);
+		}
+
+		std::cout << " - " << image_width << " x " << image_height << ": "
+			<< std::setprecision (2) << std::fixed
+			<< timer.total_in_ms () / frames << " ms/frame, "
+			<< indexed_timer.total_in_ms () / frames << " ms/frame as palette indices"
+			<< std::endl;
+	}
+	/*
+	Xeon, 1 thread, ms/frame to quantize, dither and compress (32 colors):
+		                exhaustive search   RGB cube of candidates
+		1024 x 576           128.52               111.89
+		4096 x 2304         2122.81              1944.03
+	Identical indices. Searching and dithering take 2.1x less time, learning the
+	palette (NeuQuant) is now ~60% of the encoding and LZW ~20%.
+
+	Palette indices of the color map (128 colors) skip both and are only compressed:
+		1024 x 576            34.64 ms/frame (~3.8x)
+		4096 x 2304          423.24 ms/frame (~4.3x)
+	The gif grows by ~50%, LZW compresses the undithered 128 colors worse.
+	*/
+}
+
+void bench_coloring () {
+	const size_t repetitions = 50;
+
+	std::cout << "Running               : bench_coloring" << std::endl;
+	std::cout << "Repetitions           : " << repetitions << "\n" << std::endl;
+
+	auto fractal_zoom = create_zooming ();
+	std::cout << std::endl;
+
+	const auto host_ext = detect_cpu_ext ();
+	auto fill_row = select_row_kernel (host_ext, 8);
+	auto fill_count_row = select_count_row_kernel (host_ext, 8);
+	for (auto [image_width, image_height] : { std::pair{ 1024, 576 }, std::pair{ 4096, 2304 } }) {
+		std::vector<pixel_t> image (image_width * image_height);
+		std::vector<pixel_t> copy (image_width * image_height);
+		std::vector<iteration_count_t> counts (image_width * image_height);
+		auto [lower_left, upper_right] = fractal_zoom.frame_bounds (0);
+		auto scale = compute_scale (lower_left, upper_right, image_width, image_height);
+		auto iterations = fractal_zoom.frame_iterations (0);
+		auto series = fractal_zoom.frame_series (lower_left, upper_right, scale, iterations);
+
+		Timer render_timer;
+		Timer count_timer;
+		for (size_t i = 0; i < repetitions / 10; i++)
+		{
+			render_timer.start ("render");
+			fill_row (0, image_height, 0, image_width, image.data (), fractal_zoom, lower_left, scale, iterations, series, image_width, image_height);
+			render_timer.stop ();
+			count_timer.start ("render");
+			fill_count_row (0, image_height, 0, image_width, counts.data (), fractal_zoom, lower_left, scale, iterations, series, image_width, image_height);
+			count_timer.stop ();
+		}
+
+		std::cout << " - " << image_width << " x " << image_height << ":" << std::endl
+			<< std::setprecision (2) << std::fixed
+			<< "   render colors " << render_timer.total_in_ms () / (repetitions / 10) << " ms/frame, "
+			<< "iteration counts " << count_timer.total_in_ms () / (repetitions / 10) << " ms/frame" << std::endl;
+
+		Timer copy_timer;
+		copy_timer.start ("copy");
+		for (size_t i = 0; i < repetitions; i++)
+		{
+			std::copy (std::begin (image), std::end (image), std::begin (copy));
+		}
+		copy_timer.stop ();
+		std::cout << "   copy colors   " << std::setw (8) << copy_timer.total_in_ms () / repetitions << " ms/frame" << std::endl;
+
+		for (auto cpu_ext : { FracUseCPUExt::None, FracUseCPUExt::AVX, FracUseCPUExt::AVX_FMA, FracUseCPUExt::AVX512 }) {
+			if (cpu_ext > host_ext)
+				break;
+
+			auto color_frame = select_color_kernel (cpu_ext);
+			Timer timer;
+			timer.start ("color");
+			for (size_t i = 0; i < repetitions; i++)
+			{
+				color_frame (counts.data (), counts.size (), fractal_zoom.color_map.data (), copy.data ());
+			}
+			timer.stop ();
+			std::cout << "   color " << std::setw (8) << cpu_ext_name (cpu_ext)
+				<< std::setw (8) << timer.total_in_ms () / repetitions << " ms/frame"
+				<< (copy == image ? "" : " (colors differ!)") << std::endl;
+		}
+	}
+	/*
+	Xeon with AVX-512, 1 thread, ms/frame of the first frame:
+		                   1024 x 576   4096 x 2304
+		render colors         4.73         41.00
+		render counts         5.11         40.99
+		copy colors           0.24          5.74
+		color (scalar)        0.31          6.74
+		color (AVX2 gather)   0.16          6.04
+		color (AVX-512)       0.16          5.66
+	Coloring a frame of counts costs about as much as copying the colors, so
+	other colors need no rendering. The counts take half the memory of RGBA,
+	the kernels are bound by the iterations and render them as fast.
+	*/
+}
+
+/**
+Renders frames along the zoom in float and in double. The pixels which differ
+are the ones float gets wrong, the frames marked with * are the ones
+FractalZooming::Precision::Auto renders in double.
+*/
+void bench_precision () {
+	int image_width = 1024; int image_height = 576;
+	const size_t repetitions = 3;
+
+	std::cout << "Running               : bench_precision" << std::endl;
+	std::cout << "Resolution            : " << image_width << " x " << image_height << " pixels" << std::endl;
+	std::cout << "Repetitions           : " << repetitions << "\n" << std::endl;
+
+	auto fractal_zoom = create_zooming ();
+	std::cout << std::endl;
+
+	auto fill_row = select_row_kernel (detect_cpu_ext (), 4);
+	std::vector<pixel_t> float_image (image_width * image_height);
+	std::vector<pixel_t> double_image (image_width * image_height);
+	for (size_t i = 0; i < fractal_zoom.zoom_steps; i++)
+	{
+		if (i % 20 == 0 || i + 1 == fractal_zoom.zoom_steps) {
+			auto [lower_left, upper_right] = fractal_zoom.frame_bounds (i);
+			auto scale = compute_scale (lower_left, upper_right, image_width, image_height);
+			auto iterations = fractal_zoom.frame_iterations (i);
+			// frames this shallow are never approximated
+			series_t series;
+			bool auto_double = fractal_zoom.frame_precision (scale) != FractalZooming::Precision::Float;
+
+			Timer float_timer;
+			Timer double_timer;
+			for (size_t r = 0; r < repetitions; r++)
+			{
+				fractal_zoom.precision = FractalZooming::Precision::Float;
+				float_timer.start ("float");
+				fill_row (0, image_height, 0, image_width, float_image.data (), fractal_zoom, lower_left, scale, iterations, series, image_width, image_height);
+				float_timer.stop ();
+				fractal_zoom.precision = FractalZooming::Precision::Double;
+				double_timer.start ("double");
+				fill_row (0, image_height, 0, image_width, double_image.data (), fractal_zoom, lower_left, scale, iterations, series, image_width, image_height);
+				double_timer.stop ();
+			}
+			fractal_zoom.precision = FractalZooming::Precision::Auto;
+
+			size_t differ = 0;
+			for (size_t p = 0; p < float_image.size (); p++)
+			{
+				differ += float_image[p] != double_image[p];
+			}
+			std::cout << " - frame " << std::setw (3) << i << (auto_double ? "*" : " ")
+				<< " spacing " << std::setprecision (2) << std::scientific << scale[0]
+				<< std::fixed
+				<< ": float " << std::setw (6) << float_timer.total_in_ms () / repetitions << " ms, "
+				<< "double " << std::setw (6) << double_timer.total_in_ms () / repetitions << " ms, "
+				<< std::setw (6) << 100.0 * differ / float_image.size () << "% of the pixels differ"
+				<< std::endl;
+		}
+	}
+	/*
+	Xeon with AVX-512, x4 kernels (float: 16 lanes per vector, double: 4), 1 thread:
+		frame   spacing    float     double    pixels differ
+		    0   3.9e-03    2.43 ms    4.92 ms    0.06%
+		  100   2.3e-05    5.74 ms   17.60 ms    0.20%
+		  160   1.1e-06    8.69 ms   29.45 ms    1.48%
+		  180*  3.8e-07   11.94 ms   37.92 ms    2.82%
+		  199*  1.4e-07   12.97 ms   48.09 ms    2.04%
+	Double costs 2x of AVX2 float and 3-4x of AVX-512 float, so Auto keeps
+	float until the last frames of this zoom, where the edges get stair steps.
+	The 29 more bits of double last for another ~390 frames at a zoom of 0.95.
+	*/
+}
+
+/**
+Renders frames of the zoom in double and with perturbation where both resolve
+the pixels, then frames down to a depth of 1e-100 which only perturbation
+resolves, with and without the series approximation. The depth is the width
+of a frame.
+*/
+void bench_perturbation () {
+	int image_width = 1024; int image_height = 576;
+	const size_t repetitions = 3;
+
+	std::cout << "Running               : bench_perturbation" << std::endl;
+	std::cout << "Resolution            : " << image_width << " x " << image_height << " pixels" << std::endl;
+	std::cout << "Repetitions           : " << repetitions << "\n" << std::endl;
+
+	auto fractal_zoom = create_zooming ();
+	// i is a Misiurewicz point on the border of the set, its frames have detail at any depth
+	fractal_zoom.zoom_center = complex_t{ 0, 1 };
+	fractal_zoom.iterations = 1024;
+	fractal_zoom.color_map.resize (fractal_zoom.iterations, fractal_zoom.color_map.back ());
+	fractal_zoom.compute_reference_orbit ();
+	std::cout << "Reference orbit       : " << fractal_zoom.reference_orbit.size () << " points\n" << std::endl;
+
+	auto fill_row = select_row_kernel (detect_cpu_ext (), 4);
+	std::vector<pixel_t> double_image (image_width * image_height);
+	std::vector<pixel_t> perturbation_image (image_width * image_height);
+	std::vector<pixel_t> series_image (image_width * image_height);
+	auto count_differ = [](const std::vector<pixel_t>& a, const std::vector<pixel_t>& b) {
+		size_t differ = 0;
+		for (size_t p = 0; p < a.size (); p++)
+		{
+			differ += a[p] != b[p];
+		}
+		return differ;
+	};
+	// ms per frame and the iterations the series skipped
+	auto render = [&](size_t frame, FractalZooming::Precision precision, FractalZooming::SeriesApproximation approximation, std::vector<pixel_t>& image) {
+		auto [lower_left, upper_right] = fractal_zoom.frame_bounds (frame);
+		auto scale = compute_scale (lower_left, upper_right, image_width, image_height);
+		auto iterations = fractal_zoom.frame_iterations (frame);
+		fractal_zoom.precision = precision;
+		fractal_zoom.series_approximation = approximation;
+		auto series = fractal_zoom.frame_series (lower_left, upper_right, scale, iterations);
+		Timer timer;
+		for (size_t r = 0; r < repetitions; r++)
+		{
+			timer.start ("render");
+			fill_row (0, image_height, 0, image_width, image.data (), fractal_zoom, lower_left, scale, iterations, series, image_width, image_height);
+			timer.stop ();
+		}
+		fractal_zoom.precision = FractalZooming::Precision::Auto;
+		fractal_zoom.series_approximation = FractalZooming::SeriesApproximation::Cubic;
+		return std::make_tuple (timer.total_in_ms () / repetitions, series.skipped);
+	};
+
+	for (size_t i : { 0, 100, 200, 300, 400, 500 }) {
+		auto [double_ms, double_skipped] = render (i, FractalZooming::Precision::Double, FractalZooming::SeriesApproximation::No, double_image);
+		auto [perturbation_ms, perturbation_skipped] = render (i, FractalZooming::Precision::Perturbation, FractalZooming::SeriesApproximation::No, perturbation_image);
+		size_t differ = count_differ (double_image, perturbation_image);
+		std::cout << " - frame " << std::setw (4) << i
+			<< std::setprecision (2) << std::fixed
+			<< ": double " << std::setw (6) << double_ms << " ms, "
+			<< "perturbation " << std::setw (6) << perturbation_ms << " ms, "
+			<< std::setw (6) << 100.0 * differ / double_image.size () << "% of the pixels differ"
+			<< std::endl;
+	}
+	std::cout << std::endl;
+
+	double width = fractal_zoom.start_upper_right.real () - fractal_zoom.start_lower_left.real ();
+	for (int exponent = 10; exponent <= 100; exponent += 15) {
+		auto frame = (size_t)std::ceil (std::log (std::pow (10.0, -exponent) / width) / std::log ((double)fractal_zoom.zoom));
+		auto [lower_left, upper_right] = fractal_zoom.frame_bounds (frame);
+		auto scale = compute_scale (lower_left, upper_right, image_width, image_height);
+		bool auto_perturbation = fractal_zoom.frame_precision (scale) == FractalZooming::Precision::Perturbation;
+		auto [ms, no_skipped] = render (frame, FractalZooming::Precision::Perturbation, FractalZooming::SeriesApproximation::No, perturbation_image);
+		auto [series_ms, skipped] = render (frame, FractalZooming::Precision::Perturbation, FractalZooming::SeriesApproximation::Cubic, series_image);
+		size_t differ = count_differ (perturbation_image, series_image);
+		std::cout << " - depth 1e-" << std::setw (3) << std::left << exponent << std::right
+			<< " frame " << std::setw (4) << frame << (auto_perturbation ? "*" : " ")
+			<< ": perturbation " << std::setprecision (2) << std::fixed << std::setw (6) << ms << " ms, "
+			<< "series " << std::setw (6) << series_ms << " ms, "
+			<< std::setw (4) << skipped << " iterations skipped, "
+			<< std::setw (6) << 100.0 * differ / series_image.size () << "% of the pixels differ"
+			<< std::endl;
+	}
+	/*
+	Xeon with AVX-512, x4 kernels (4 lanes per vector), 1 thread, budget 1024:
+		frame   double     perturbation   pixels differ
+		    0   13.22 ms   49.25 ms       0.00%
+		  200    6.91 ms   17.71 ms       0.00%
+		  400   10.64 ms   26.18 ms       0.00%
+		  500   12.81 ms   31.82 ms       0.05%
+	Perturbation costs 2.5x of double, 4x in the first frame, where many
+	offsets are as large as the points and rebase. The pixels of frame 500
+	which differ are the ones double starts to round.
+
+		depth    frame   perturbation   series    skipped iterations
+		1e-10     476     28.68 ms      9.91 ms     25
+		1e-25    1150*    58.68 ms      9.79 ms     65
+		1e-40    1823*    86.33 ms      9.57 ms    105
+		1e-70    3170*   146.25 ms      9.88 ms    184
+		1e-100   4517*   201.90 ms      9.69 ms    264
+	Marked frames are beyond double, Auto renders them with perturbation. The
+	time grows with the iterations the points near i need, not with the depth
+	itself. Pixels of the frames at 1e-30 and 1e-45 match an iteration of
+	their points in 140 digits.
+	The series skips all but the last few iterations the pixels share, the
+	pixels are identical and the frames stay at ~10 ms at any depth (20x at
+	1e-100).
+	*/
+}
+
+/**
+Renders frames of the zoom around i from a depth of 1e-5 to 1e-30 in
+double-double, next to double and to perturbation with and without the series
+approximation.
+*/
+void bench_double_double () {
+	int image_width = 1024; int image_height = 576;
+	const size_t repetitions = 3;
+
+	std::cout << "Running               : bench_double_double" << std::endl;
+	std::cout << "Resolution            : " << image_width << " x " << image_height << " pixels" << std::endl;
+	std::cout << "Repetitions           : " << repetitions << "\n" << std::endl;
+
+	auto fractal_zoom = create_zooming ();
+	fractal_zoom.zoom_center = complex_t{ 0, 1 };
+	fractal_zoom.iterations = 1024;
+	fractal_zoom.color_map.resize (fractal_zoom.iterations, fractal_zoom.color_map.back ());
+	fractal_zoom.compute_reference_orbit ();
+	std::cout << std::endl;
+
+	auto fill_row = select_row_kernel (detect_cpu_ext (), 4);
+	std::vector<pixel_t> double_double_image (image_width * image_height);
+	std::vector<pixel_t> image (image_width * image_height);
+	auto render = [&](size_t frame, FractalZooming::Precision precision, FractalZooming::SeriesApproximation approximation, std::vector<pixel_t>& image) {
+		auto [lower_left, upper_right] = fractal_zoom.frame_bounds (frame);
+		auto scale = compute_scale (lower_left, upper_right, image_width, image_height);
+		auto iterations = fractal_zoom.frame_iterations (frame);
+		fractal_zoom.precision = precision;
+		fractal_zoom.series_approximation = approximation;
+		auto series = fractal_zoom.frame_series (lower_left, upper_right, scale, iterations);
+		Timer timer;
+		for (size_t r = 0; r < repetitions; r++)
+		{
+			timer.start ("render");
+			fill_row (0, image_height, 0, image_width, image.data (), fractal_zoom, lower_left, scale, iterations, series, image_width, image_height);
+			timer.stop ();
+		}
+		fractal_zoom.precision = FractalZooming::Precision::Auto;
+		fractal_zoom.series_approximation = FractalZooming::SeriesApproximation::Cubic;
+		return timer.total_in_ms () / repetitions;
+	};
+
+	double width = fractal_zoom.start_upper_right.real () - fractal_zoom.start_lower_left.real ();
+	for (int exponent = 5; exponent <= 30; exponent += 5) {
+		auto frame = (size_t)std::ceil (std::log (std::pow (10.0, -exponent) / width) / std::log ((double)fractal_zoom.zoom));
+		double double_double_ms = render (frame, FractalZooming::Precision::DoubleDouble, FractalZooming::SeriesApproximation::No, double_double_image);
+		double double_ms = render (frame, FractalZooming::Precision::Double, FractalZooming::SeriesApproximation::No, image);
+		double perturbation_ms = render (frame, FractalZooming::Precision::Perturbation, FractalZooming::SeriesApproximation::No, image);
+		size_t differ = 0;
+		for (size_t p = 0; p < image.size (); p++)
+		{
+			differ += image[p] != double_double_image[p];
+		}
+		double series_ms = render (frame, FractalZooming::Precision::Perturbation, FractalZooming::SeriesApproximation::Cubic, image);
+		std::cout << " - depth 1e-" << std::setw (2) << std::left << exponent << std::right
+			<< " frame " << std::setw (4) << frame
+			<< std::setprecision (2) << std::fixed
+			<< ": double-double " << std::setw (6) << double_double_ms << " ms, "
+			<< "double " << std::setw (6) << double_ms << " ms, "
+			<< "perturbation " << std::setw (6) << perturbation_ms << " ms, "
+			<< "series " << std::setw (6) << series_ms << " ms, "
+			<< std::setw (6) << 100.0 * differ / image.size () << "% of the pixels differ from perturbation"
+			<< std::endl;
+	}
+	/*
+	Xeon with AVX-512, x4 kernels (4 lanes per vector), 1 thread, budget 1024:
+		depth    frame   double-double   double      perturbation   series
+		1e-5      252     31.28 ms        8.04 ms    19.11 ms       9.37 ms
+		1e-10     476     49.70 ms       12.73 ms    28.54 ms       9.64 ms
+		1e-15     701     66.73 ms       22.12 ms    36.13 ms       9.08 ms
+		1e-20     925     86.25 ms      332.96 ms    46.65 ms      11.30 ms
+		1e-25    1150    104.52 ms      337.68 ms    55.15 ms       9.56 ms
+		1e-30    1374    122.14 ms      335.31 ms    62.29 ms       8.41 ms
+	Double-double costs ~4x of double and ~2x of perturbation, the pixels are
+	identical to perturbation at every depth. Beyond 1e-15 double rounds all
+	pixels onto a few points next to i, which run through the whole budget.
+	So Auto takes perturbation with the reference orbit and double-double only
+	without one.
+	*/
+}
+
+/** Keeps every period-th frame, to compare the frames of two renderers */
+class KeepFramesSink : public FrameSink {
+	size_t _period;
+	size_t _count = 0;
+
+public:
+	std::vector<std::vector<pixel_t>> frames;
+
+	KeepFramesSink (size_t period)
+		: _period{ period } { }
+
+	using FrameSink::append_frame;
+
+	void append_frame (const pixel_t* frame, size_t count) override {
+		if (_count++ % _period == 0)
+			frames.emplace_back (frame, frame + count);
+	}
+};
+
+/** Prints the share of the pixels of the kept frames which differ from the reference ones and by more than 16 levels */
+void print_frame_differences (const std::string& name, const KeepFramesSink& kept, const KeepFramesSink& reference) {
+	size_t differ = 0;
+	size_t far_off = 0;
+	size_t pixels = 0;
+	for (size_t f = 0; f < kept.frames.size (); f++)
+	{
+		for (size_t p = 0; p < kept.frames[f].size (); p++)
+		{
+			const pixel_t& a = kept.frames[f][p];
+			const pixel_t& b = reference.frames[f][p];
+			int distance = std::max ({ std::abs (a.r - b.r), std::abs (a.g - b.g), std::abs (a.b - b.b) });
+			differ += distance != 0;
+			far_off += distance > 16;
+			pixels++;
+		}
+	}
+	std::cout << " - " << name << ": "
+		<< std::setprecision (3) << std::fixed
+		<< 100.0 * differ / pixels << "% of the pixels differ, "
+		<< 100.0 * far_off / pixels << "% by more than 16 levels"
+		<< std::endl;
+}
+
+/**
+Renders the zoom with temporal reprojection (FracCPU_TR) at 1 sample per
+pixel next to GSLP, and at 2x2 samples per pixel with every sample iterated
+in every frame and samples reused with a few refresh periods. The reused
+frames are compared with the ones which iterate every sample.
+*/
+void bench_reprojection () {
+	int image_width = 1024; int image_height = 576;
+	const size_t compared_period = 10;
+
+	std::cout << "Running               : bench_reprojection" << std::endl;
+	std::cout << "Resolution            : " << image_width << " x " << image_height << " pixels\n" << std::endl;
+
+	auto fractal_zoom = create_zooming ();
+	std::cout << std::endl;
+
+	const size_t tasks = std::thread::hardware_concurrency ();
+	FracCPU_GSLP<FracUseCPUExt::Auto, 4, FracProgress::None> frac_cpu_gslp{ image_width, image_height, tasks };
+	FracCPU_TR<FracUseCPUExt::Auto, 4, FracProgress::None> frac_cpu_full{ image_width, image_height, tasks, 2, 1 };
+	FracCPU_TR<FracUseCPUExt::Auto, 4, FracProgress::None> frac_cpu_tr_8{ image_width, image_height, tasks, 2, 8 };
+	FracCPU_TR<FracUseCPUExt::Auto, 4, FracProgress::None> frac_cpu_tr_32{ image_width, image_height, tasks, 2, 32 };
+	FracCPU_TR<FracUseCPUExt::Auto, 4, FracProgress::None> frac_cpu_tr_1x1{ image_width, image_height, tasks, 1, 8 };
+	auto full_frames = std::make_shared<KeepFramesSink> (compared_period);
+	auto frames_8 = std::make_shared<KeepFramesSink> (compared_period);
+	auto frames_32 = std::make_shared<KeepFramesSink> (compared_period);
+	frac_cpu_full.add_sink (full_frames);
+	frac_cpu_tr_8.add_sink (frames_8);
+	frac_cpu_tr_32.add_sink (frames_32);
+
+	execute_and_print_summary (fractal_zoom, frac_cpu_gslp, frac_cpu_tr_1x1, frac_cpu_full, frac_cpu_tr_8, frac_cpu_tr_32);
+	compare_times (frac_cpu_full, frac_cpu_gslp, frac_cpu_tr_1x1, frac_cpu_tr_8, frac_cpu_tr_32);
+
+	std::cout << "\nEvery " << compared_period << "th frame compared to iterating every sample:" << std::endl;
+	print_frame_differences (frac_cpu_tr_8.name (), *frames_8, *full_frames);
+	print_frame_differences (frac_cpu_tr_32.name (), *frames_32, *full_frames);
+	/*
+	Xeon with AVX-512, x4 kernels (4 lanes per vector), 1 thread:
+		renderer                          time      not iterated
+		GSLP, 1 sample per pixel          2.16 s    32.01% per frame
+		TR 1x1, refresh every 8           1.45 s    78.26% per frame
+		TR 2x2, every sample iterated    13.41 s    32.01% per frame
+		TR 2x2, refresh every 8           7.44 s    81.66% per frame
+		TR 2x2, refresh every 32          6.66 s    87.00% per frame
+	Reusing samples iterates ~2.6x fewer of them, 0.16% (every 8) and 0.19%
+	(every 32) of the pixels differ from iterating every sample, 0.02% by
+	more than 16 levels. At 1 sample per pixel TR takes ~0.67x of GSLP, 2x2
+	takes 3.1-3.4x of GSLP for 4x the samples. The refreshed rows and the long
+	runs go to the row kernel, the samples at the edges are too scattered for
+	it (~3 per run) and go to the point kernel. Before, the refresh hashed
+	every sample and the averaging divided every channel, 1.27 s of TR 1x1
+	went to the averaging alone, which made it ~1.4x slower than GSLP.
+	*/
+}
+
+/**
+Renders the zoom from keyframes (FracCPU_KF) of 2x2 samples per pixel every 2x
+and 4x of zoom, next to GSLP at 1 sample per pixel and a keyframe per frame,
+which iterates every sample. The frames cropped from the keyframes are
+compared with the ones of a keyframe per frame.
+*/
+void bench_keyframes () {
+	int image_width = 1024; int image_height = 576;
+	const size_t compared_period = 10;
+
+	std::cout << "Running               : bench_keyframes" << std::endl;
+	std::cout << "Resolution            : " << image_width << " x " << image_height << " pixels\n" << std::endl;
+
+	auto fractal_zoom = create_zooming ();
+	std::cout << std::endl;
+
+	const size_t tasks = std::thread::hardware_concurrency ();
+	FracCPU_GSLP<FracUseCPUExt::Auto, 4, FracProgress::None> frac_cpu_gslp{ image_width, image_height, tasks };
+	FracCPU_KF<FracUseCPUExt::Auto, 4, FracProgress::None> frac_cpu_full{ image_width, image_height, tasks, 2, 1 };
+	FracCPU_KF<FracUseCPUExt::Auto, 4, FracProgress::None> frac_cpu_kf_2{ image_width, image_height, tasks, 2, 2 };
+	FracCPU_KF<FracUseCPUExt::Auto, 4, FracProgress::None> frac_cpu_kf_4{ image_width, image_height, tasks, 2, 4 };
+	auto full_frames = std::make_shared<KeepFramesSink> (compared_period);
+	auto frames_2 = std::make_shared<KeepFramesSink> (compared_period);
+	auto frames_4 = std::make_shared<KeepFramesSink> (compared_period);
+	frac_cpu_full.add_sink (full_frames);
+	frac_cpu_kf_2.add_sink (frames_2);
+	frac_cpu_kf_4.add_sink (frames_4);
+
+	execute_and_print_summary (fractal_zoom, frac_cpu_gslp, frac_cpu_full, frac_cpu_kf_2, frac_cpu_kf_4);
+	compare_times (frac_cpu_full, frac_cpu_gslp, frac_cpu_kf_2, frac_cpu_kf_4);
+
+	std::cout << "\nThroughput per sequence:" << std::endl;
+	for (const auto* frac : { &frac_cpu_full, &frac_cpu_kf_2, &frac_cpu_kf_4 }) {
+		std::cout << " - " << frac->name () << ": "
+			<< frac->keyframes () << " keyframes for " << fractal_zoom.zoom_steps << " frames, "
+			<< std::setprecision (2) << std::fixed
+			<< fractal_zoom.zoom_steps / frac->timer ().total ().count () << " frames/s, "
+			<< (double)frac->iterated_samples () / fractal_zoom.zoom_steps / (image_width * image_height) << " samples iterated per pixel"
+			<< std::endl;
+	}
+
+	std::cout << "\nEvery " << compared_period << "th frame compared to a keyframe per frame:" << std::endl;
+	print_frame_differences (frac_cpu_kf_2.name (), *frames_2, *full_frames);
+	print_frame_differences (frac_cpu_kf_4.name (), *frames_4, *full_frames);
+	/*
+	Xeon with AVX-512, x4 kernels (4 lanes per vector), 1 thread:
+		renderer                        time      keyframes   samples iterated per pixel
+		GSLP, 1 sample per pixel        2.86 s    -           -
+		KF 2x2, keyframe per frame     13.58 s    200         2.72
+		KF 2x2, keyframe every 2x       2.65 s     15         0.21
+		KF 2x2, keyframe every 4x       2.39 s      8         0.11
+	A keyframe every 2x iterates ~13x fewer samples and renders 75 frames/s
+	instead of 15, at 2x2 samples per pixel a little faster than GSLP at 1.
+	Cropping the frames takes most of the time then. 8.4% (every 2x) and 9.2%
+	(every 4x) of the pixels differ from a keyframe per frame, 2.0% and 2.4%
+	by more than 16 levels, mostly details the deeper frames resolve sharper.
+	*/
+}
+
+/**
+Renders the zoom into a FrameStore at store_file instead of memory, encode_store
+turns it into a gif or video later. The frames in flight are the only ones in
+memory, so this works at the target resolution as well.
+*/
+void store_frames (const std::string& store_file) {
+	//int image_width = 8192; int image_height = 4608;
+	int image_width = 1024; int image_height = 576;
+
+	std::cout << "Running               : store_frames" << std::endl;
+	std::cout << "Resolution            : " << image_width << " x " << image_height << " pixels" << std::endl;
+	std::cout << "Frame store           : " << store_file << "\n" << std::endl;
+
+	auto fractal_zoom = create_zooming ();
+	std::cout << std::endl;
+
+	// a frame per task is in flight
+	FracCPU_GPLP<FracUseCPUExt::Auto, 8> frac_cpu{ image_width, image_height,
+		std::thread::hardware_concurrency (), std::thread::hardware_concurrency () };
+	frac_cpu.store_frames (store_file);
+
+	execute_and_print_summary (fractal_zoom, frac_cpu);
+	/*
+	Xeon, 1 thread, 8192 x 4608, 16 frames rendered at once (2.4 GB):
+		                 no limit   limited to 1 GB of memory
+		in memory         6.44 s    killed (out of memory)
+		frame store       5.69 s    4.88 s
+	The frames in flight are resident either way while there is enough memory,
+	but the pages of the store are written back and dropped under pressure.
+	*/
+}
+
+/** Encodes the frames of a store written by store_frames into zoom.gif, and video_target unless it is empty */
+void encode_store (const std::string& store_file, const std::string& video_target, std::string_view video_format) {
+	FrameStore<> store (store_file);
+
+	std::cout << "Running               : encode_store" << std::endl;
+	std::cout << "Resolution            : " << store.width () << " x " << store.height () << " pixels" << std::endl;
+	std::cout << "Frames                : " << store.frames_done () << " of " << store.frame_count () << "\n" << std::endl;
+
+	AnimatedGif image ("zoom.gif", store.width (), store.height ());
+	auto sink = video_target.empty ()
+		? nullptr
+		: open_frame_sink (video_target, video_format, store.width (), store.height (), 30);
+	auto delay = std::chrono::duration<short, std::centi>{ 3 };
+	size_t pixel_count = (size_t)store.width () * store.height ();
+
+	Timer timer;
+	timer.start ("encode");
+	for (size_t i = 0; i < store.frames_done (); i++)
+	{
+		image.append_frame (store.frame (i), pixel_count, delay, true);
+		if (sink)
+			sink->append_frame (store.frame (i), pixel_count);
+		store.release (i, 1);
+
+		if (i % 10 == 0) {
+			std::cout << i << " ";
+		}
+	}
+	std::cout << std::endl;
+	timer.stop ();
+
+	std::cout << "Done in " << timer.total ().count () << "s" << std::endl;
+}
+
+/** Streams the frames to video_target as well unless it is empty, see open_frame_sink */
+void test_bed (const std::string& video_target, std::string_view video_format) {
 	// target res: 8.192 x 4.608
 	//int image_width = 8192; int image_height = 4608;
 	//int image_width = 4096; int image_height = 2304;
@@ -158,15 +986,23 @@ void test_bed () {
 
 	auto fractal_zoom = create_zooming ();
 	fractal_zoom.save_images = FractalZooming::SaveImage::ToDisk;
+	fractal_zoom.coloring = FractalZooming::Coloring::Smooth;
+	// the frames only have the colors of the gradient, no need to quantize them
+	fractal_zoom.frame_format = FractalZooming::FrameFormat::PaletteIndices;
 	std::cout << std::endl;
 
 	// Current best: GPLP
 	// On FH: GPLS
-	FracCPU_GPLP<FracUseCPUExt::AVX_FMA, 8> frac_cpu{ image_width, image_height,
+	FracCPU_GPLP<FracUseCPUExt::Auto, 8> frac_cpu{ image_width, image_height,
 		64, std::thread::hardware_concurrency() };
-	FracCPU_GPLS<FracUseCPUExt::AVX_FMA, 8> frac_cpu_gpls{ image_width, image_height,
+	FracCPU_GPLS<FracUseCPUExt::Auto, 8> frac_cpu_gpls{ image_width, image_height,
 		64};
-	FracCPU_GSLP<FracUseCPUExt::AVX_FMA, 8> frac_cpu_gslp{ image_width, image_height, 64};
+	// encoding a frame takes longer than rendering it, so one encoder per core
+	FracCPU_GSLP<FracUseCPUExt::Auto, 8> frac_cpu_gslp{ image_width, image_height, std::thread::hardware_concurrency (),
+		64, 16, std::thread::hardware_concurrency () + 1 };
+
+	if (!video_target.empty ())
+		frac_cpu_gslp.add_sink (open_frame_sink (video_target, video_format, image_width, image_height, 30));
 
 	execute_and_print_summary (fractal_zoom, frac_cpu_gslp);
 	return;
@@ -179,12 +1015,84 @@ void test_bed () {
 	// compare_times (frac_cpu, frac_cpu_gpls, frac_cpu_gslp, frac_gpu);
 }
 
-int main () {
+/**
+FractalZoom [mode] [video target] [video format], the test bed streams the
+frames to the video target as well, "-" is stdout, e.g.
+	FractalZoom test_bed - | ffmpeg -i - zoom.mp4
+	FractalZoom test_bed zoom.rgba rgba
+The frame store modes take the store first:
+	FractalZoom store_frames zoom.frames
+	FractalZoom encode_store zoom.frames [video target] [video format]
+*/
+int main (int argc, char* argv[]) {
+	std::string_view mode = argc > 1 ? argv[1] : "test_bed";
+	std::string store_file = argc > 2 ? argv[2] : "zoom.frames";
+	int video_arg = mode == "encode_store" ? 3 : 2;
+	std::string video_target = argc > video_arg ? argv[video_arg] : "";
+	std::string_view video_format = argc > video_arg + 1 ? argv[video_arg + 1] : "y4m";
+	// the video goes to stdout, so the text goes to stderr
+	if (video_target == "-")
+		std::cout.rdbuf (std::cerr.rdbuf ());
+
 	print_cpu_summary ();
+	std::cout << std::endl;
+
+	if (mode == "bench_kernels") {
+		bench_kernels ();
+		return 0;
+	}
+	if (mode == "bench_parallelizers") {
+		bench_parallelizers ();
+		return 0;
+	}
+	if (mode == "bench_mariani_silver") {
+		bench_mariani_silver ();
+		return 0;
+	}
+	if (mode == "bench_gif") {
+		bench_gif ();
+		return 0;
+	}
+	if (mode == "bench_coloring") {
+		bench_coloring ();
+		return 0;
+	}
+	if (mode == "bench_precision") {
+		bench_precision ();
+		return 0;
+	}
+	if (mode == "bench_perturbation") {
+		bench_perturbation ();
+		return 0;
+	}
+	if (mode == "bench_double_double") {
+		bench_double_double ();
+		return 0;
+	}
+	if (mode == "bench_reprojection") {
+		bench_reprojection ();
+		return 0;
+	}
+	if (mode == "bench_keyframes") {
+		bench_keyframes ();
+		return 0;
+	}
+	if (mode == "store_frames") {
+		store_frames (store_file);
+		return 0;
+	}
+	if (mode == "encode_store") {
+		encode_store (store_file, video_target, video_format);
+		return 0;
+	}
+	if (mode == "find_best") {
+		find_best ();
+		return 0;
+	}
 
 	// std::cout << "\nSetting process priority to High ...";
 	// SetPriorityClass (GetCurrentProcess (), HIGH_PRIORITY_CLASS);
 	// std::cout << " Done!\n" << std::endl;
 
-	test_bed ();
+	test_bed (video_target, video_format);
 }
@@ -1,6 +1,14 @@
 #include <vector>
+#include <deque>
+#include <algorithm>
+#include <memory>
+#include <functional>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
 #include <thread>
 #include <future>
+#include <exception>
 
 class thread_group {
     std::vector <std::thread> _in_progress;
@@ -57,4 +65,203 @@ public:
     void join_all () {
         for (auto & f : _in_progress) f.wait ();
     }
+};
+
+/*
+Persistent pool of worker threads. Every worker owns a deque, it takes its own
+tasks from the back and steals from the front of the other deques when its
+own one is empty.
+*/
+class thread_pool {
+    struct worker_queue {
+        std::mutex mutex;
+        std::deque <std::function <void ()>> tasks;
+    };
+
+    static constexpr size_t no_worker = static_cast <size_t> (-1);
+    inline static thread_local thread_pool* _current_pool = nullptr;
+    inline static thread_local size_t _current_worker = no_worker;
+
+    std::vector <std::unique_ptr <worker_queue>> _queues;
+    std::vector <std::thread> _workers;
+    std::atomic <size_t> _next_queue {0};
+    // tasks pushed but not yet taken, guarded by _sleep_mutex for the workers going to sleep
+    std::atomic <size_t> _queued {0};
+    std::mutex _sleep_mutex;
+    std::condition_variable _wake;
+    bool _stop = false;
+
+public:
+    explicit thread_pool (size_t worker_count = std::max (std::thread::hardware_concurrency (), 1u)) {
+        for (size_t i = 0; i < worker_count; i++)
+            _queues.push_back (std::make_unique <worker_queue> ());
+        for (size_t i = 0; i < worker_count; i++)
+            _workers.emplace_back ([this, i] () { work (i); });
+    }
+
+    thread_pool (const thread_pool&) = delete;
+    thread_pool& operator= (const thread_pool&) = delete;
+
+    ~thread_pool () {
+        {
+            std::lock_guard <std::mutex> lock (_sleep_mutex);
+            _stop = true;
+        }
+        _wake.notify_all ();
+        for (auto & t : _workers) t.join ();
+    }
+
+    // shared by all groups, created on first use
+    static thread_pool& instance () {
+        static thread_pool pool;
+        return pool;
+    }
+
+    size_t worker_count () const {
+        return _workers.size ();
+    }
+
+    void submit (std::function <void ()> task) {
+        // workers keep the tasks they create, others are spread round robin
+        size_t index = _current_pool == this
+            ? _current_worker
+            : _next_queue++ % _queues.size ();
+        {
+            std::lock_guard <std::mutex> lock (_queues[index]->mutex);
+            _queues[index]->tasks.push_back (std::move (task));
+        }
+        {
+            std::lock_guard <std::mutex> lock (_sleep_mutex);
+            _queued++;
+        }
+        _wake.notify_one ();
+    }
+
+    // runs one queued task on the calling thread, false if there was none
+    bool run_one () {
+        std::function <void ()> task;
+        if (!take (task))
+            return false;
+        task ();
+        return true;
+    }
+
+private:
+    bool take (std::function <void ()>& task) {
+        size_t own = _current_pool == this ? _current_worker : no_worker;
+        if (own != no_worker) {
+            auto & queue = *_queues[own];
+            std::lock_guard <std::mutex> lock (queue.mutex);
+            if (!queue.tasks.empty ()) {
+                task = std::move (queue.tasks.back ());
+                queue.tasks.pop_back ();
+                _queued--;
+                return true;
+            }
+        }
+
+        size_t start = own != no_worker ? own + 1 : 0;
+        for (size_t i = 0; i < _queues.size (); i++) {
+            auto & queue = *_queues[(start + i) % _queues.size ()];
+            std::lock_guard <std::mutex> lock (queue.mutex);
+            if (!queue.tasks.empty ()) {
+                task = std::move (queue.tasks.front ());
+                queue.tasks.pop_front ();
+                _queued--;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void work (size_t index) {
+        _current_pool = this;
+        _current_worker = index;
+        while (true) {
+            if (run_one ())
+                continue;
+
+            std::unique_lock <std::mutex> lock (_sleep_mutex);
+            _wake.wait (lock, [this] () { return _stop || _queued > 0; });
+            if (_stop && _queued == 0)
+                return;
+        }
+    }
+};
+
+/*
+Group of tasks running on the shared thread_pool, a drop-in for thread_group and
+task_group which does not start a thread per task. join_all runs queued tasks
+while it waits and rethrows the first exception a task threw, like the futures
+of task_group keep it.
+*/
+class pool_group {
+    thread_pool& _pool;
+    size_t _pending = 0;
+    std::exception_ptr _error;
+    std::mutex _mutex;
+    std::condition_variable _done;
+
+public:
+    explicit pool_group (thread_pool& pool = thread_pool::instance ()) : _pool {pool} { }
+
+    // the queued tasks refer to the group, so it can neither be copied nor moved
+    pool_group (const pool_group&) = delete;
+    pool_group& operator= (const pool_group&) = delete;
+
+    template <typename TFunc, typename... TArgs>
+    void add (TFunc&& func, TArgs&&... args) {
+        {
+            std::lock_guard <std::mutex> lock (_mutex);
+            _pending++;
+        }
+        _pool.submit ([this, task = std::bind (std::forward <TFunc> (func), std::forward <TArgs> (args)...)] () mutable {
+            std::exception_ptr error;
+            try {
+                task ();
+            }
+            catch (...) {
+                error = std::current_exception ();
+            }
+            std::lock_guard <std::mutex> lock (_mutex);
+            if (error && !_error)
+                _error = error;
+            if (--_pending == 0)
+                _done.notify_all ();
+        });
+    }
+
+    void join_all () {
+        wait_all ();
+
+        std::exception_ptr error;
+        {
+            std::lock_guard <std::mutex> lock (_mutex);
+            std::swap (error, _error);
+        }
+        if (error)
+            std::rethrow_exception (error);
+    }
+
+    // a destructor can not throw, the exception is lost if join_all was not called
+    ~pool_group () {
+        wait_all ();
+    }
+
+private:
+    void wait_all () {
+        while (true) {
+            {
+                std::lock_guard <std::mutex> lock (_mutex);
+                if (_pending == 0)
+                    return;
+            }
+            if (!_pool.run_one ())
+                break;
+        }
+
+        // the remaining tasks are running on the workers
+        std::unique_lock <std::mutex> lock (_mutex);
+        _done.wait (lock, [this] () { return _pending == 0; });
+    }
 };
\ No newline at end of file
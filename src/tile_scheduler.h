@@ -0,0 +1,101 @@
+#pragma once
+
+#include <vector>
+#include <atomic>
+#include <chrono>
+#include <numeric>
+#include <algorithm>
+
+/**
+Hands out the tiles of a frame through an atomic counter, so tasks which are
+done early take over the remaining work. The tiles are ordered by the time they
+took in the previous frame, most expensive first, so that no costly tile is
+started last while the other tasks are already idle.
+*/
+class TileScheduler {
+public:
+	/** Tile of pixels, x1 and y1 are exclusive */
+	struct tile_t {
+		int x0, y0, x1, y1;
+	};
+
+	using Clock = std::chrono::steady_clock;
+
+	static constexpr size_t no_tile = static_cast<size_t> (-1);
+
+private:
+	std::vector<tile_t> _tiles;
+	/** Time every tile took when it was rendered last */
+	std::vector<Clock::duration> _costs;
+	std::vector<int> _cost_class;
+	/** Tile indices, most expensive first */
+	std::vector<size_t> _order;
+	std::atomic<size_t> _next{ 0 };
+
+public:
+	TileScheduler (int image_width, int image_height, int tile_width, int tile_height) {
+		for (int y = 0; y < image_height; y += tile_height)
+		{
+			for (int x = 0; x < image_width; x += tile_width)
+			{
+				_tiles.push_back ({ x, y,
+					std::min (x + tile_width, image_width),
+					std::min (y + tile_height, image_height) });
+			}
+		}
+		_costs.assign (_tiles.size (), Clock::duration::zero ());
+		_cost_class.assign (_tiles.size (), 0);
+		_order.resize (_tiles.size ());
+		std::iota (std::begin (_order), std::end (_order), size_t{ 0 });
+	}
+
+	// the tasks of a frame refer to the scheduler
+	TileScheduler (const TileScheduler&) = delete;
+	TileScheduler& operator= (const TileScheduler&) = delete;
+
+	/**
+	Orders the tiles by their last cost and starts handing them out again, call
+	before the tasks start. Costs are compared by their power of four only, the
+	tiles of the same class stay in image order as jumping around the image
+	costs more than a slightly imperfect order.
+	*/
+	void begin_frame () {
+		for (size_t i = 0; i < _tiles.size (); i++)
+		{
+			_cost_class[i] = cost_class (_costs[i]);
+		}
+		std::iota (std::begin (_order), std::end (_order), size_t{ 0 });
+		std::stable_sort (std::begin (_order), std::end (_order), [this](size_t a, size_t b) {
+			return _cost_class[a] > _cost_class[b];
+		});
+		_next.store (0, std::memory_order_relaxed);
+	}
+
+	/** Index of the next tile to render, no_tile once all of them are taken */
+	size_t next () {
+		size_t i = _next.fetch_add (1, std::memory_order_relaxed);
+		return i < _order.size () ? _order[i] : no_tile;
+	}
+
+	static int cost_class (Clock::duration cost) {
+		int cost_class = 0;
+		for (auto ns = std::chrono::duration_cast<std::chrono::nanoseconds> (cost).count (); ns > 1; ns >>= 2)
+		{
+			cost_class++;
+		}
+		return cost_class;
+	}
+
+	const tile_t& tile (size_t index) const {
+		return _tiles[index];
+	}
+
+	/** Only the task which rendered the tile may set its cost */
+	void set_cost (size_t index, Clock::duration cost) {
+		_costs[index] = cost;
+	}
+
+	size_t tile_count () const {
+		return _tiles.size ();
+	}
+};
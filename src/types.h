@@ -1,5 +1,7 @@
 #pragma once
 
+#include <cstdint>
+
 struct RGBA
 {
 	unsigned char r;
@@ -7,4 +9,16 @@ struct RGBA
 	unsigned char b;
 	unsigned char a;
 };
-using pixel_t = RGBA;
\ No newline at end of file
+using pixel_t = RGBA;
+/** Pixel stored as an index into a palette of at most 256 colors */
+using palette_index_t = unsigned char;
+/** Pixel stored as its entry of the color map, colored by a separate pass (see color_frame_fn) */
+using iteration_count_t = std::uint16_t;
+
+inline bool operator== (const RGBA& a, const RGBA& b) {
+	return a.r == b.r && a.g == b.g && a.b == b.b && a.a == b.a;
+}
+
+inline bool operator!= (const RGBA& a, const RGBA& b) {
+	return !(a == b);
+}